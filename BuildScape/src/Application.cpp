@@ -11,6 +11,11 @@
 #include <stdint.h>
 #include <cstdint>
 #include <chrono>
+#include <string>
+#include <cstdio>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
 
 #include "Input.h"
 #include "Camera.h"
@@ -18,12 +23,25 @@
 #include "World.h"
 #include "Renderer.h"
 #include "Debug.h"
-
-// unsigned 32 bit int, 26/32
+#include "ChunkStreamer.h"
+#include "Benchmark.h"
+#include "EditJournal.h"
+#include "Raycast.h"
+#include "CpuRenderer.h"
+#include "Collision.h"
+#include "EntitySystem.h"
+#include "Random.h"
+#include "BlockTextures.h"
+#include "ShaderProgram.h"
+#include "Profiler.h"
+#include "GpuTimer.h"
+#include "FrameRecorder.h"
+#include "CameraPath.h"
+
+// unsigned 32 bit int, 14/32
 // 
-// x position   = 4 bits
-// y position   = 4 bits
-// z position   = 4 bits
+// The position follows from the block's index in its chunk (Chunk::getX/getY/getZ)
+//
 // id			= 8 bits
 // face up		= 1 bit
 // face down	= 1 bit
@@ -42,6 +60,7 @@
 // 8 bits = 0xFF = 0 - 255
 
 bool internalFaceCulling = false;
+bool cameraCollision = false;
 bool backFaceCulling = true;
 
 // Game variables
@@ -60,11 +79,24 @@ glm::vec3 normalUp = glm::vec3(0.0f, 1.0f, 0.0f);
 Camera camera(normalPos, normalFront, normalUp, 1.0f, 45.0f, 1.0f);
 Renderer renderer;
 World world(voxelSize, 4, &camera, &renderer);
+ChunkStreamer streamer(&world, &camera, 6, 64 * 1024 * 1024);
+EditJournal journal(16 * 1024 * 1024);
+RaycastHit pickedBlock;
+float pickDistance = 8.0f;
+std::uint8_t placeId = 2;
+CpuRenderer cpuRenderer(&world);
+EntitySystem entities(&world, 60.0f, 8);
+BlockTextures blockTextures;
+ShaderProgram chunkShader(&renderer, "src/shaders/chunk.vert", "src/shaders/chunk.frag");
+ShaderProgram pointShader(&renderer, "src/shaders/point.vert", "src/shaders/point.frag");
+GpuTimer worldGpuTimer("GPU World::draw", 240);
+GpuTimer debugGpuTimer("GPU Debug::draw", 240);
+glm::mat4 projection;
 Debug debug("Debug window", 300, windowHeight);
 
 // Other variables
 float deltaTime = 0.0f;
-float lastFrame = 0.0f;
+double lastFrame = 0.0;
 bool firstMouse = true;
 
 int wireframe = 0;
@@ -72,14 +104,15 @@ bool recording = false;
 float recordingTime = 10;
 float recordingTimer = 0;
 float recordCamSpeed = 3;
-int frameCounter = 0;
-float fpsCounter = 0;
+FrameRecorder frameRecorder(1 << 16);
+FrameStatistics recordingStatistics = {};
 bool uiCollapsed = false;
 
 bool checkCurrentChunk = false;
 
 // Input
 void processInput(GLFWwindow* window) {
+	PROFILE_SCOPE("processInput");
 	checkCurrentChunk = false;
 
 	if (Input::getKeyDown(GLFW_KEY_ESCAPE)) {
@@ -103,8 +136,30 @@ void processInput(GLFWwindow* window) {
 		checkCurrentChunk = true;
 	}
 
+	// Block to place, lamps give off light
+	if (Input::getKeyDown(GLFW_KEY_1)) placeId = 1;
+	if (Input::getKeyDown(GLFW_KEY_2)) placeId = 2;
+	if (Input::getKeyDown(GLFW_KEY_3)) placeId = 3;
+
+	// Pick the block the camera looks at, the mouse edits it while it's used to look around
+	Raycast::cast(world, camera.getPosition(), camera.getFront(), pickDistance, pickedBlock);
+	if (pickedBlock.hit && !Input::isMouseIgnored()) {
+		EditBatch batch;
+		if (Input::getMouseButtonDown(GLFW_MOUSE_BUTTON_LEFT)) batch.setBlock(pickedBlock.voxel, 0);
+
+		// A camera inside a block hits it without a face to place against
+		bool hasFace = pickedBlock.normal != glm::ivec3(0);
+		if (Input::getMouseButtonDown(GLFW_MOUSE_BUTTON_RIGHT) && hasFace) batch.setBlock(pickedBlock.voxel + pickedBlock.normal, placeId);
+		if (!batch.isEmpty()) journal.apply(world, batch);
+	}
+
+	// Undo and redo
+	bool control = Input::getKey(GLFW_KEY_LEFT_CONTROL);
+	if (control && Input::getKeyDown(GLFW_KEY_Z)) journal.undo(world);
+	if (control && Input::getKeyDown(GLFW_KEY_Y)) journal.redo(world);
+
 	// Collapse
-	if (Input::getKeyDown(GLFW_KEY_Z)) {
+	if (!control && Input::getKeyDown(GLFW_KEY_Z)) {
 		uiCollapsed = !uiCollapsed;
 		debug.setCollapsed(uiCollapsed);
 		debug.setSize(uiCollapsed ? 200 : 300, uiCollapsed ? 100 : windowHeight);
@@ -118,7 +173,7 @@ void processInput(GLFWwindow* window) {
 
 		recording = true;
 		recordingTimer = recordingTime;
-		frameCounter = 0;
+		frameRecorder.start();
 	}
 
 	if (recording) {
@@ -136,6 +191,9 @@ void processInput(GLFWwindow* window) {
 		}
 	}
 
+	// Movement is collected first, so it can be checked against the voxels
+	glm::vec3 startPosition = camera.getPosition();
+
 	// Speed
 	float cameraSpeed = (Input::getKey(GLFW_KEY_LEFT_SHIFT) ? 10.0f : 5.0f) * deltaTime;
 	camera.setSpeed(cameraSpeed);
@@ -176,6 +234,15 @@ void processInput(GLFWwindow* window) {
 		if (!camera.getLocked()) checkCurrentChunk = true;
 	}
 
+	// Slide along the blocks in the way, the camera is at the top of a box a bit less than 2 blocks high
+	if (cameraCollision) {
+		AABB box;
+		box.min = startPosition - glm::vec3(0.3f, 1.5f, 0.3f) * voxelSize;
+		box.max = startPosition + glm::vec3(0.3f, 0.2f, 0.3f) * voxelSize;
+		CollisionResult result = Collision::move(world, box, camera.getPosition() - startPosition);
+		camera.setPosition(startPosition + result.delta);
+	}
+
 	if (checkCurrentChunk && backFaceCulling) {
 		world.checkChunk(false);
 	}
@@ -187,33 +254,420 @@ void toggleBackfaceCulling() {
 	else world.checkChunk(true);
 }
 
-void regenerateWorld() {
+void toggleCameraCollision() {
+	cameraCollision = !cameraCollision;
+}
+
+void toggleInternalFaceCulling() {
+	// Only the face bits change, the meshes are rebuilt at the end of the frame
 	internalFaceCulling = !internalFaceCulling;
+	if (internalFaceCulling) world.internalFaceCull();
+	else world.showInternalFaces();
+}
+
+void toggleStreaming() {
+	streamer.setEnabled(!streamer.isEnabled());
+
+	// Swap between the fixed test area and chunks streamed around the camera
+	bool culled = world.areInternalFacesCulled();
+	world.save();
+	world.clear();
+	journal.clear();
+	if (!streamer.isEnabled()) world.generate();
+	if (culled) world.internalFaceCull();
+}
+
+void saveWorld() {
+	auto start = std::chrono::high_resolution_clock::now();
+	bool saved = world.save();
+	std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+
+	if (saved) std::cout << "Saved the world in " << duration.count() << " seconds\n";
+	else std::cout << "[ERROR] Saving the world failed." << std::endl;
+}
+
+void benchmarkChunkLoading() {
+	Benchmark::chunkLoading(world, 20);
+}
+
+void benchmarkChunkCompression() {
+	Benchmark::chunkCompression(world, 100);
+}
+
+void fillTestCube() {
+	// A fill that can be undone
+	EditBatch batch;
+	batch.fill(glm::ivec3(-32, 8, -32), glm::ivec3(32, 72, 32), 2);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	int changed = journal.apply(world, batch);
+	std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "Changed " << changed << " blocks in " << duration.count() * 1000.0 << " ms\n";
+}
+
+void benchmarkBlockEdits() {
+	Benchmark::blockEdits(world, 64);
+}
+
+void renderOnCpu() {
+	// Same view as the window, so the image can be compared with what the GPU draws
+	if (!cpuRenderer.renderToFile(camera.getViewMatrix(), projection, windowWidth, windowHeight, "render.png")) return;
+
+	std::cout << "Rendered render.png on " << cpuRenderer.getThreadCount() << " threads in " << cpuRenderer.getLastRenderTime() * 1000.0
+		<< " ms, " << cpuRenderer.getRaysPerSecond() / 1000000.0 << " million rays per second" << std::endl;
+}
+
+void toggleProfiler() {
+	Profiler::setEnabled(!Profiler::isEnabled());
+}
+
+void captureTrace() {
+	// Written once the frames are done
+	Profiler::startCapture(120, "trace.json");
+}
+
+void spawnEntities() {
+	// A cloud of entities in front of the camera
+	glm::vec3 centre = camera.getPosition() + camera.getFront() * 2.0f;
+	for (int i = 0; i < 1000; i++) {
+		glm::vec3 offset(Random::range(-50, 50), Random::range(-50, 50), Random::range(-50, 50));
+		glm::vec3 velocity(Random::range(-20, 20), Random::range(0, 20), Random::range(-20, 20));
+		entities.spawn(centre + offset * 0.01f, velocity * voxelSize, glm::vec3(0.3f) * voxelSize);
+	}
+}
+
+void benchmarkEntities() {
+	Benchmark::entities(world, 100000, 60);
+}
+
+void benchmarkSpatialHash() {
+	Benchmark::spatialHash(world, 10000);
+}
+
+void benchmarkLighting() {
+	Benchmark::lighting(world);
+}
+
+void rebuildThroughOctree() {
+	// Find the chunks that are currently resident
+	glm::ivec3 minChunk(INT_MAX);
+	glm::ivec3 maxChunk(INT_MIN);
+	for (auto& pair : world.getChunks()) {
+		minChunk = glm::min(minChunk, pair.second->getCoordinates());
+		maxChunk = glm::max(maxChunk, pair.second->getCoordinates());
+	}
+	size_t chunkBytes = world.getMemoryUsage();
+
+	// Convert the world, then compare the tree before and after deduplicating subtrees
+	auto start = std::chrono::high_resolution_clock::now();
+	Octree octree(16);
+	if (!world.toOctree(octree)) return;
+	size_t treeBytes = octree.getMemoryUsage();
+	size_t treeNodes = octree.getNodeCount();
+	octree.deduplicate();
+	std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+
+	std::cout << "Converted the world to an octree in " << duration.count() << " seconds\n";
+	std::cout << "Chunks: " << chunkBytes / 1024 << " KB\n";
+	std::cout << "Octree: " << treeBytes / 1024 << " KB, " << treeNodes << " nodes\n";
+	std::cout << "DAG:    " << octree.getMemoryUsage() / 1024 << " KB, " << octree.getNodeCount() << " nodes" << std::endl;
+
+	// Replace the chunks with the ones converted back from the octree
+	bool culled = world.areInternalFacesCulled();
+	world.save();
 	world.clear();
+	journal.clear();
+	if (culled) world.internalFaceCull();
+	if (minChunk.x <= maxChunk.x) world.fromOctree(octree, minChunk, maxChunk);
+	if (backFaceCulling) world.checkChunk(true);
+}
+
+void toggleOctreeBackend() {
+	// Block queries and edits go through the octree, the resident chunks are still meshed and drawn
+	bool enabled = !world.isOctreeBackend();
+	if (!world.setOctreeBackend(enabled)) return;
+	std::cout << "Block storage: " << (enabled ? "octree" : "chunks") << std::endl;
+}
+
+std::string octreeStats() {
+	if (!world.isOctreeBackend()) return "Block storage: chunks";
+
+	char text[64];
+	snprintf(text, sizeof(text), "Block storage: octree, %.1f KB", world.getOctreeMemoryUsage() / 1024.0f);
+	return text;
+}
+
+std::string streamingStats() {
+	if (!streamer.isEnabled()) return "Streaming: off";
+
+	char text[256];
+	snprintf(text, sizeof(text), "Streaming: %d chunks, %.1f / %.1f MB\nEvicted chunks: %d\nCold chunks: %d, %.1f KB\nCold hit rate: %.1f%%, %.1f us decompress",
+		streamer.getResidentCount(), streamer.getResidentBytes() / (1024.0f * 1024.0f),
+		streamer.getMemoryBudget() / (1024.0f * 1024.0f), streamer.getEvictedCount(),
+		streamer.getColdCount(), streamer.getColdBytes() / 1024.0f,
+		streamer.getColdHitRate() * 100.0f, streamer.getAverageDecompressTime() * 1000000.0);
+	return text;
+}
+
+std::string journalStats() {
+	char text[64];
+	snprintf(text, sizeof(text), "Undo: %d, redo: %d, %.1f KB", journal.getUndoCount(), journal.getRedoCount(), journal.getMemoryUsage() / 1024.0f);
+	return text;
+}
+
+std::string pickStats() {
+	if (!pickedBlock.hit) return "Looking at: nothing";
+
+	char text[96];
+	snprintf(text, sizeof(text), "Looking at: %d, %d, %d (id %d), %.2f away",
+		pickedBlock.voxel.x, pickedBlock.voxel.y, pickedBlock.voxel.z, pickedBlock.id, pickedBlock.distance);
+	return text;
+}
+
+std::string entityStats() {
+	char text[96];
+	snprintf(text, sizeof(text), "Entities: %d (%d drawn), %.2f ms per tick", entities.getCount(), entities.getDrawnCount(), entities.getLastTickTime() * 1000.0);
+	return text;
+}
+
+static std::string gpuTimerStats(const char* pLabel, GpuTimer& pTimer) {
+	char text[96];
+	snprintf(text, sizeof(text), "%s: %.2f ms (min %.2f, p99 %.2f)", pLabel, pTimer.getAverageTime(), pTimer.getMinTime(), pTimer.getPercentileTime(99.0));
+	return text;
+}
+
+std::string worldGpuStats() {
+	return gpuTimerStats("GPU world", worldGpuTimer);
+}
+
+std::string debugGpuStats() {
+	return gpuTimerStats("GPU debug window", debugGpuTimer);
+}
+
+std::string recordingStats() {
+	char text[128];
+	snprintf(text, sizeof(text), "Recording: %d frames, p99 %.2f ms, 1%% low %.1f FPS", recordingStatistics.frames, recordingStatistics.p99, recordingStatistics.onePercentLowFps);
+	return text;
+}
+
+std::string lightStats() {
+	char text[64];
+	LightEngine& lighting = world.getLighting();
+	snprintf(text, sizeof(text), "Light: %.2f ms, %d voxels", lighting.getLastUpdateTime() * 1000.0, lighting.getLastNodeCount());
+	return text;
+}
+
+std::string meshStats() {
+	char text[64];
+	snprintf(text, sizeof(text), "Chunk meshes: %.1f MB", world.getMeshMemoryUsage() / (1024.0f * 1024.0f));
+	return text;
+}
+
+// Draws the world, the entities and the debug window, then rebuilds the meshes that changed
+void renderFrame(GLFWwindow* pWindow) {
+	// OpenGL clear
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// Pick up edited shader files
+	if (chunkShader.reloadIfChanged()) world.setShaderProgram(chunkShader.getProgram());
+	pointShader.reloadIfChanged();
+
+	// Shader uniforms
+	GLuint shaderProgram = chunkShader.getProgram();
+	glUseProgram(shaderProgram);
+	GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
+	GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
+	GLuint wireLoc = glGetUniformLocation(shaderProgram, "wireframe");
+
+	glUniform1i(wireLoc, wireframe);
+
+	glm::mat4 view = camera.getViewMatrix();
+	
+	glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+	glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+	blockTextures.bind(shaderProgram);
+
+	// Render world and debug window
+	worldGpuTimer.begin();
+	world.draw();
+	worldGpuTimer.end();
+
+	// Entities have their own shader for points
+	GLuint pointProgram = pointShader.getProgram();
+	glUseProgram(pointProgram);
+	glUniformMatrix4fv(glGetUniformLocation(pointProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+	glUniformMatrix4fv(glGetUniformLocation(pointProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+	entities.draw(pointProgram);
+	debugGpuTimer.begin();
+	debug.draw();
+	debugGpuTimer.end();
+
+	{
+		PROFILE_SCOPE("glfwSwapBuffers");
+		glfwSwapBuffers(pWindow);
+	}
+
+	// Rebuild the meshes of the chunks that changed this frame
+	world.updateMeshes();
+}
+
+// Replays a camera path at a fixed timestep and writes the duration and counters of every frame.
+// Returns the exit code, anything but 0 means the run can't be compared with others.
+int runBenchmark(GLFWwindow* pWindow, const std::string& pPathFile, float pTimestep, const std::string& pOutput) {
+	CameraPath path;
+	if (!path.load(pPathFile)) return 1;
+
+	std::ofstream csv(pOutput);
+	if (!csv) {
+		std::cout << "[ERROR] Failed to write " << pOutput << std::endl;
+		return 1;
+	}
+	csv << "frame,time_s,frame_ms,gpu_world_ms,gpu_debug_ms,chunks_drawn,triangles_drawn,entities_drawn,mesh_mb\n";
+
+	// The path decides what's on screen, not the frame rate, so every run renders the same frames
+	std::vector<float> times = path.getSampleTimes(pTimestep);
+	std::cout << "Benchmark " << pPathFile << ": " << path.getKeyframeCount() << " keyframes, " << times.size() << " frames of " << pTimestep * 1000.0f << " ms" << std::endl;
+
+	FrameRecorder recorder((int)times.size());
+	recorder.start();
+	double frameStart = glfwGetTime();
+	size_t frame = 0;
+	char line[256];
+	for (; frame < times.size() && !glfwWindowShouldClose(pWindow); frame++) {
+		Profiler::beginFrame();
+
+		CameraKeyframe keyframe = path.sample(times[frame]);
+		camera.setPosition(keyframe.position);
+		camera.setYaw(keyframe.yaw);
+		camera.setPitch(keyframe.pitch);
+		camera.update(0.0f);
+
+		// Same updates as the game loop, with the simulated step instead of the real one
+		float step = frame == 0 ? 0.0f : times[frame] - times[frame - 1];
+		if (streamer.update() && backFaceCulling) world.checkChunk(true);
+		if (backFaceCulling) world.checkChunk(false);
+		entities.update(step);
+
+		renderFrame(pWindow);
+		glfwPollEvents();
+
+		double frameEnd = glfwGetTime();
+		double frameTime = frameEnd - frameStart;
+		frameStart = frameEnd;
+		recorder.addFrame(frameTime);
+
+		// GPU times are the latest results that came back, a few frames behind
+		snprintf(line, sizeof(line), "%d,%.4f,%.4f,%.4f,%.4f,%d,%d,%d,%.2f\n", (int)frame, times[frame], frameTime * 1000.0,
+			worldGpuTimer.getLastTime(), debugGpuTimer.getLastTime(), world.getDrawnChunkCount(), world.getDrawnTriangleCount(),
+			entities.getDrawnCount(), world.getMeshMemoryUsage() / (1024.0 * 1024.0));
+		csv << line;
+	}
+	recorder.stop();
+	recorder.print();
+	std::cout << "Frames written to " << pOutput << std::endl;
+
+	if (frame < times.size()) {
+		std::cout << "[ERROR] Benchmark was stopped after " << frame << " of " << times.size() << " frames." << std::endl;
+		return 1;
+	}
+
+	GLenum error = glGetError();
+	if (error != GL_NO_ERROR) {
+		std::cout << "[ERROR] OpenGL error " << error << " during the benchmark." << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int renderHeadless(const std::string& pOutput, int pWidth, int pHeight) {
+	// Nothing here touches GLFW or OpenGL, so images can be rendered on machines without a GPU
+	world.setSaveDirectory("world");
 	world.generate();
-	if (internalFaceCulling) world.internalFaceCull();
+	world.getLighting().update();
+
+	glm::mat4 view = camera.getViewMatrix();
+	glm::mat4 cpuProjection = glm::perspective(glm::radians(camera.getFov()), (float)pWidth / (float)pHeight, 0.1f, 100.0f);
+	bool written = cpuRenderer.renderToFile(view, cpuProjection, pWidth, pHeight, pOutput);
+	world.clear();
+	if (!written) return 1;
+
+	std::cout << "Rendered " << pOutput << " on " << cpuRenderer.getThreadCount() << " threads in " << cpuRenderer.getLastRenderTime() * 1000.0
+		<< " ms, " << cpuRenderer.getRaysPerSecond() / 1000000.0 << " million rays per second" << std::endl;
+	return 0;
 }
 
-int main(void) {
+static void printUsage() {
+	std::cout << "Usage: BuildScape [--benchmark <camera path>] [--timestep <seconds>] [--output <csv>] [--culling none|back|internal|all] [--seed <number>]\n";
+	std::cout << "       BuildScape --render-cpu <png> [--width <pixels>] [--height <pixels>]\n";
+}
+
+int main(int argc, char* argv[]) {
 	auto start = std::chrono::high_resolution_clock::now();
 
-	// Vertices
-	float verDist = voxelSize / 2.0f;
-	const float cubeVertices[] = {
-		-verDist, -verDist, -verDist,
-		 verDist, -verDist, -verDist,
-		-verDist,  verDist, -verDist,
-		 verDist,  verDist, -verDist,
-		-verDist, -verDist,  verDist,
-		 verDist, -verDist,  verDist,
-		-verDist,  verDist,  verDist,
-		 verDist,  verDist,  verDist
-	};
-
-	int numVertices = sizeof(cubeVertices) / sizeof(cubeVertices[0]);
+	// Command line, a benchmark replays a camera path and exits, a CPU render writes one image without a window
+	std::string benchmarkPath;
+	std::string renderPath;
+	int renderWidth = windowWidth;
+	int renderHeight = windowHeight;
+	std::string benchmarkOutput = "benchmark.csv";
+	float benchmarkTimestep = 1.0f / 60.0f;
+	unsigned int benchmarkSeed = 1;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		char* valueEnd = nullptr;
+
+		if (argument == "--benchmark" && value) {
+			benchmarkPath = value;
+		} else if (argument == "--output" && value) {
+			benchmarkOutput = value;
+		} else if (argument == "--timestep" && value) {
+			benchmarkTimestep = std::strtof(value, &valueEnd);
+			if (*valueEnd != '\0' || benchmarkTimestep <= 0.0f) {
+				std::cout << "[ERROR] The timestep has to be a number of seconds above 0." << std::endl;
+				return 2;
+			}
+		} else if (argument == "--render-cpu" && value) {
+			renderPath = value;
+		} else if ((argument == "--width" || argument == "--height") && value) {
+			long pixels = std::strtol(value, &valueEnd, 10);
+			if (*valueEnd != '\0' || pixels <= 0 || pixels > 16384) {
+				std::cout << "[ERROR] The image size has to be between 1 and 16384 pixels." << std::endl;
+				return 2;
+			}
+			if (argument == "--width") renderWidth = (int)pixels;
+			else renderHeight = (int)pixels;
+		} else if (argument == "--seed" && value) {
+			benchmarkSeed = (unsigned int)std::strtoul(value, &valueEnd, 10);
+			if (*valueEnd != '\0') {
+				std::cout << "[ERROR] The seed has to be a number." << std::endl;
+				return 2;
+			}
+		} else if (argument == "--culling" && value) {
+			std::string mode = value;
+			if (mode != "none" && mode != "back" && mode != "internal" && mode != "all") {
+				printUsage();
+				return 2;
+			}
+			backFaceCulling = mode == "back" || mode == "all";
+			internalFaceCulling = mode == "internal" || mode == "all";
+		} else {
+			printUsage();
+			return 2;
+		}
+		i++;
+	}
+	bool benchmarking = !benchmarkPath.empty();
+	if (!renderPath.empty()) {
+		if (benchmarking) {
+			printUsage();
+			return 2;
+		}
+		return renderHeadless(renderPath, renderWidth, renderHeight);
+	}
 
 	// Initialize renderer (GLFW / OpenGL)
-	if (renderer.initialize(windowWidth, windowHeight, std::string(windowName + " - " + gameVersion), cubeVertices, numVertices) == -1)
+	if (renderer.initialize(windowWidth, windowHeight, std::string(windowName + " - " + gameVersion)) == -1)
 		return -1;
 
 	GLFWwindow* window = renderer.getWindow();
@@ -226,85 +680,116 @@ int main(void) {
 	debug.addLine("[T] Look at the wireframes of the voxels");
 	debug.addLine("[G] Look at the triangles of the voxels");
 	debug.addLine("[C] Toggle locked camera");
+	debug.addLine("[Ctrl+Z] Undo, [Ctrl+Y] Redo");
 	debug.addLine("");
 	debug.addLine("[WASDQE] Move the camera");
 	debug.addLine("[Mouse] Look around");
+	debug.addLine("[LMB/RMB] Remove / place a block");
+	debug.addLine("[1-3] Pick the block to place, 3 is a lamp");
 	debug.addLine("");
 	debug.addButton("Toggle backface culling", &toggleBackfaceCulling);
-	debug.addButton("Toggle internal face culling", &regenerateWorld);
-
-	// Generate world
-	world.generate();
+	debug.addButton("Toggle internal face culling", &toggleInternalFaceCulling);
+	debug.addButton("Toggle camera collision", &toggleCameraCollision);
+	debug.addButton("Toggle chunk streaming", &toggleStreaming);
+	debug.addButton("Save world", &saveWorld);
+	debug.addButton("Benchmark chunk loading", &benchmarkChunkLoading);
+	debug.addButton("Benchmark chunk compression", &benchmarkChunkCompression);
+	debug.addButton("Fill test cube", &fillTestCube);
+	debug.addButton("Benchmark block edits", &benchmarkBlockEdits);
+	debug.addButton("Spawn entities", &spawnEntities);
+	debug.addButton("Benchmark entities", &benchmarkEntities);
+	debug.addButton("Benchmark spatial hash", &benchmarkSpatialHash);
+	debug.addButton("Benchmark lighting", &benchmarkLighting);
+	debug.addButton("Render on CPU", &renderOnCpu);
+	debug.addButton("Rebuild world through octree", &rebuildThroughOctree);
+	debug.addButton("Toggle octree block storage", &toggleOctreeBackend);
+	debug.addButton("Toggle profiler", &toggleProfiler);
+	debug.addButton("Capture profiler trace", &captureTrace);
+	debug.addStat(&streamingStats);
+	debug.addStat(&octreeStats);
+	debug.addStat(&meshStats);
+	debug.addStat(&lightStats);
+	debug.addStat(&journalStats);
+	debug.addStat(&pickStats);
+	debug.addStat(&entityStats);
+	debug.addStat(&worldGpuStats);
+	debug.addStat(&debugGpuStats);
+	debug.addStat(&recordingStats);
+	debug.addPanel(&Profiler::drawTimeline);
+
+	// Block textures decode while the world generates, the placed block is a crate
+	int crateLayer = blockTextures.addTexture("src/img/crate.png");
+	if (crateLayer) blockTextures.setBlock(2, crateLayer);
+	blockTextures.load();
+
+	// Generate world, loading the chunks that were saved before.
+	// Benchmarks always start from the same freshly generated world.
+	if (benchmarking) Random::seed(benchmarkSeed);
+	else world.setSaveDirectory("world");
+	// The textures are uploaded as soon as they're decoded, so the mipmaps are generated during the rest of the world
+	world.generate([]() {
+		if (blockTextures.isDecoded()) blockTextures.finishLoading();
+	});
 	if (internalFaceCulling) world.internalFaceCull();
 
-	// Shaders
-	const char* vertexShaderSource = R"(
-		#version 330 core
-		layout(location = 0) in vec3 aPos;
+	// Shaders, compiled programs are cached and the files are reloaded when they change
+	ShaderProgram::setCacheDirectory("shadercache");
+	chunkShader.load();
+	pointShader.load();
+	world.setShaderProgram(chunkShader.getProgram());
 
-		out vec3 outColor;
-
-		uniform mat4 model;
-		uniform mat4 view;
-		uniform mat4 projection;
-
-		uniform vec3 col;
-
-		void main() {
-			gl_Position = projection * view * model * vec4(aPos, 1.0);
-			vec3 vertexColor = col;
-
-			if (aPos.x > 0.0) vertexColor.x++;
-			if (aPos.y > 0.0) vertexColor.y++;
-			if (aPos.z > 0.0) vertexColor.z++;
-
-			outColor = vertexColor;
-		}
-	)";
-
-	const char* fragmentShaderSource = R"(
-		#version 330 core
-		out vec4 FragColor;
-
-		in vec3 outColor;
-
-		void main() {
-			FragColor = vec4(outColor, 1.0);
-		}
-	)";
-
-	GLuint vertexShader = renderer.setShader(vertexShaderSource, GL_VERTEX_SHADER);
-	GLuint fragmentShader = renderer.setShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
-	GLuint shaderProgram = renderer.createShaderProgram(vertexShader, fragmentShader);
-	world.setShaderProgram(shaderProgram);
+	// Waits for the textures if decoding took longer than the world
+	blockTextures.finishLoading();
 
 	// MVP
-	glm::mat4 view;
-	glm::mat4 projection = glm::perspective(glm::radians(camera.getFov()), (float)windowWidth / (float)windowHeight, 0.1f, 100.0f);
+	projection = glm::perspective(glm::radians(camera.getFov()), (float)windowWidth / (float)windowHeight, 0.1f, 100.0f);
 
 	auto end = std::chrono::high_resolution_clock::now();
 	std::chrono::duration<double> duration = end - start;
 	std::cout << "Execution time: " << duration.count() << " seconds\n";
 
+	// A benchmark replaces the game loop
+	int exitCode = benchmarking ? runBenchmark(window, benchmarkPath, benchmarkTimestep, benchmarkOutput) : 0;
+
 	// Game loop
-	while (!glfwWindowShouldClose(window)) {
-		// Delta time
-		float currentFrame = glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
+	while (!benchmarking && !glfwWindowShouldClose(window)) {
+		Profiler::beginFrame();
+
+		// Delta time, the frame's own duration is kept in double precision for the recorder
+		double currentFrame = glfwGetTime();
+		double frameTime = currentFrame - lastFrame;
+		deltaTime = (float)frameTime;
 		lastFrame = currentFrame;
 
 		// Input and camera movement
 		processInput(window);
 
+		// Load and evict chunks around the camera
+		{
+			PROFILE_SCOPE("ChunkStreamer::update");
+			if (streamer.update() && backFaceCulling) {
+				world.checkChunk(true);
+			}
+		}
+
+		// Simulate the entities at a fixed rate
+		{
+			PROFILE_SCOPE("EntitySystem::update");
+			entities.update(deltaTime);
+		}
+
 		if (recording) {
 			recordingTimer -= deltaTime;
-			frameCounter++;
-			fpsCounter += ImGui::GetIO().Framerate;
+			frameRecorder.addFrame(frameTime);
 
 			if (recordingTimer <= 0) {
 				recording = false;
-				fpsCounter /= frameCounter;
-				std::cout << "Amount of frames: " << frameCounter << "\nAverage FPS: " << fpsCounter << std::endl;
+				frameRecorder.stop();
+				frameRecorder.print();
+				recordingStatistics = frameRecorder.calculate();
+				if (frameRecorder.writeCsv("recording.csv") && frameRecorder.writeHistogramCsv("recording_histogram.csv", 1.0, 50)) {
+					std::cout << "Frame times written to recording.csv and recording_histogram.csv" << std::endl;
+				}
 			}
 
 			camera.translate(glm::vec3(deltaTime * recordCamSpeed, 0.0f, deltaTime * recordCamSpeed));
@@ -312,34 +797,23 @@ int main(void) {
 
 		camera.update(deltaTime);
 
-		// OpenGL clear
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// Shader uniforms
-		glUseProgram(shaderProgram);
-		GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
-		GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
-		GLuint wireLoc = glGetUniformLocation(shaderProgram, "wireframe");
-
-		glUniform1i(wireLoc, wireframe);
-
-		view = camera.getViewMatrix();
-		
-		glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-		glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-		// Render world and debug window
-		world.draw();
-		debug.draw();
-
-		glfwSwapBuffers(window);
+		renderFrame(window);
 
 		// Update input
 		Input::update();
 		glfwPollEvents();
 	}
 
+	if (!benchmarking) world.save();
+	world.clear();
+	entities.clear();
+	blockTextures.destroy();
+	chunkShader.destroy();
+	pointShader.destroy();
+	worldGpuTimer.destroy();
+	debugGpuTimer.destroy();
+
 	debug.destroy();
 	glfwTerminate();
-	return 0;
+	return exitCode;
 }
\ No newline at end of file
@@ -0,0 +1,327 @@
+#include "Benchmark.h"
+#include "ChunkCodec.h"
+#include "EntitySystem.h"
+#include "Random.h"
+#include "SpatialHash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <thread>
+
+void Benchmark::chunkLoading(World& pWorld, int pRepetitions) {
+	// Everything has to be on disk first
+	if (!pWorld.save()) {
+		std::cout << "[ERROR] Chunk loading benchmark needs a save directory." << std::endl;
+		return;
+	}
+
+	// Group the resident chunks by the region they're stored in
+	std::map<std::string, std::vector<glm::ivec2>> regionChunks;
+	for (auto& pair : pWorld.getChunks()) {
+		glm::ivec3 coordinates = pair.second->getCoordinates();
+		regionChunks[pWorld.getRegionPath(coordinates.x, coordinates.y, coordinates.z)].push_back(
+			glm::ivec2(coordinates.x & (RegionFile::SIZE - 1), coordinates.z & (RegionFile::SIZE - 1)));
+	}
+
+	double readTime = 0.0;
+	double mappedTime = 0.0;
+	size_t chunkCount = 0;
+	size_t byteCount = 0;
+
+	for (int i = 0; i < pRepetitions; i++) {
+		for (const auto& pair : regionChunks) {
+			Chunk chunk(0, 0, 0, pWorld.getChunkSize(), true);
+
+			// Read each payload into a buffer and decode it from there
+			auto start = std::chrono::high_resolution_clock::now();
+			{
+				RegionFile region(pair.first);
+				std::vector<std::uint8_t> buffer;
+				if (region.open(false)) {
+					for (const glm::ivec2& local : pair.second) {
+						if (!region.readChunk(local.x, local.y, buffer)) continue;
+						chunk.decode(buffer.data(), buffer.size());
+						chunkCount++;
+						byteCount += buffer.size();
+					}
+				}
+			}
+			auto middle = std::chrono::high_resolution_clock::now();
+
+			// Decode each payload directly from the mapped file
+			{
+				RegionFile region(pair.first);
+				if (region.open(false)) {
+					for (const glm::ivec2& local : pair.second) {
+						size_t length = 0;
+						const std::uint8_t* data = region.mapChunk(local.x, local.y, length);
+						if (data) chunk.decode(data, length);
+					}
+				}
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+
+			readTime += std::chrono::duration<double>(middle - start).count();
+			mappedTime += std::chrono::duration<double>(end - middle).count();
+		}
+	}
+
+	if (chunkCount == 0) {
+		std::cout << "No saved chunks to benchmark." << std::endl;
+		return;
+	}
+
+	std::cout << "Chunk loading (" << chunkCount / pRepetitions << " chunks, " << pRepetitions << " times, " << byteCount / chunkCount << " bytes per chunk)\n";
+	std::cout << "Read:   " << readTime * 1000.0 << " ms, " << readTime * 1000000.0 / chunkCount << " us per chunk\n";
+	std::cout << "Mapped: " << mappedTime * 1000.0 << " ms, " << mappedTime * 1000000.0 / chunkCount << " us per chunk" << std::endl;
+}
+
+void Benchmark::chunkCompression(World& pWorld, int pRepetitions) {
+	// Gather the ids of every chunk with blocks
+	std::vector<std::vector<std::uint8_t>> chunkIds;
+	for (auto& pair : pWorld.getChunks()) {
+		std::vector<std::uint32_t>& blocks = pair.second->getBlocks();
+		if (pair.second->isEmpty() || (int)blocks.size() != Chunk::VOLUME) continue;
+
+		std::vector<std::uint8_t> ids(Chunk::VOLUME);
+		for (int i = 0; i < Chunk::VOLUME; i++) {
+			ids[i] = (blocks[i] >> 12) & 0xFF;
+		}
+		chunkIds.push_back(ids);
+	}
+
+	if (chunkIds.empty()) {
+		std::cout << "No chunks with blocks to benchmark." << std::endl;
+		return;
+	}
+
+	// Compress everything, keeping the results of the last repetition to decompress
+	std::vector<std::vector<std::uint8_t>> compressed(chunkIds.size());
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < pRepetitions; i++) {
+		for (size_t j = 0; j < chunkIds.size(); j++) {
+			ChunkCodec::compress(chunkIds[j].data(), Chunk::VOLUME, Chunk::ROW, Chunk::LAYER, compressed[j]);
+		}
+	}
+	auto middle = std::chrono::high_resolution_clock::now();
+
+	std::vector<std::uint8_t> ids(Chunk::VOLUME);
+	size_t failed = 0;
+	for (int i = 0; i < pRepetitions; i++) {
+		for (size_t j = 0; j < compressed.size(); j++) {
+			if (!ChunkCodec::decompress(compressed[j].data(), compressed[j].size(), ids.data(), Chunk::VOLUME)) failed++;
+		}
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	size_t compressedBytes = 0;
+	for (const auto& data : compressed) {
+		compressedBytes += data.size();
+	}
+
+	// Throughput is measured against the 4 byte blocks chunks hold in memory
+	double rawBytes = (double)chunkIds.size() * Chunk::VOLUME * sizeof(std::uint32_t) * pRepetitions;
+	double compressTime = std::chrono::duration<double>(middle - start).count();
+	double decompressTime = std::chrono::duration<double>(end - middle).count();
+
+	std::cout << "Chunk compression (" << chunkIds.size() << " chunks, " << pRepetitions << " times)\n";
+	std::cout << "Ratio:      " << (double)chunkIds.size() * Chunk::VOLUME * sizeof(std::uint32_t) / compressedBytes << "x, " << compressedBytes / chunkIds.size() << " bytes per chunk\n";
+	std::cout << "Compress:   " << rawBytes / compressTime / (1024.0 * 1024.0) << " MB/s\n";
+	std::cout << "Decompress: " << rawBytes / decompressTime / (1024.0 * 1024.0) << " MB/s" << std::endl;
+	if (failed > 0) std::cout << "[ERROR] " << failed << " chunks failed to decompress." << std::endl;
+}
+
+void Benchmark::blockEdits(World& pWorld, int pSize) {
+	// A cube above the middle of the world, which is filled both ways and emptied again after each
+	glm::ivec3 min(-pSize / 2, 16, -pSize / 2);
+	glm::ivec3 max = min + pSize;
+	EditBatch restore;
+	restore.fill(min, max, 0);
+
+	// Fill it one setBlock call at a time
+	auto start = std::chrono::high_resolution_clock::now();
+	int changed = 0;
+	for (int y = min.y; y < max.y; y++) {
+		for (int z = min.z; z < max.z; z++) {
+			for (int x = min.x; x < max.x; x++) {
+				if (pWorld.setBlock(glm::ivec3(x, y, z), 2)) changed++;
+			}
+		}
+	}
+	auto middle = std::chrono::high_resolution_clock::now();
+	int meshes = pWorld.updateMeshes();
+	auto end = std::chrono::high_resolution_clock::now();
+	double singleTime = std::chrono::duration<double>(middle - start).count();
+
+	std::cout << "Block edits (" << pSize << "^3 fill)\n";
+	std::cout << "setBlock: " << changed << " blocks in " << singleTime * 1000.0 << " ms, "
+		<< meshes << " meshes in " << std::chrono::duration<double>(end - middle).count() * 1000.0 << " ms\n";
+
+	// Empty it again so the batch does the same work
+	pWorld.apply(restore);
+	pWorld.updateMeshes();
+
+	// Fill it with a single batch
+	start = std::chrono::high_resolution_clock::now();
+	EditBatch batch;
+	batch.fill(min, max, 2);
+	changed = pWorld.apply(batch);
+	middle = std::chrono::high_resolution_clock::now();
+	meshes = pWorld.updateMeshes();
+	end = std::chrono::high_resolution_clock::now();
+	double batchTime = std::chrono::duration<double>(middle - start).count();
+
+	std::cout << "Batch:    " << changed << " blocks in " << batchTime * 1000.0 << " ms, "
+		<< meshes << " meshes in " << std::chrono::duration<double>(end - middle).count() * 1000.0 << " ms\n";
+	std::cout << "Speed-up: " << (batchTime > 0.0 ? singleTime / batchTime : 0.0) << "x" << std::endl;
+
+	pWorld.apply(restore);
+	pWorld.updateMeshes();
+}
+
+void Benchmark::entities(World& pWorld, int pCount, int pTicks) {
+	// Entities dropped over the middle of the world with random velocities
+	float voxelSize = pWorld.getVoxelSize();
+	std::vector<glm::vec3> positions(pCount);
+	std::vector<glm::vec3> velocities(pCount);
+	for (int i = 0; i < pCount; i++) {
+		positions[i] = glm::vec3(Random::range(-16, 47), Random::range(8, 72), Random::range(-16, 47)) * voxelSize;
+		velocities[i] = glm::vec3(Random::range(-10, 10), 0, Random::range(-10, 10)) * voxelSize;
+	}
+
+	// Compare a single thread with all of them, each from the same starting point
+	std::cout << "Entities (" << pCount << " entities, " << pTicks << " ticks)\n";
+	int threads = std::max(1, (int)std::thread::hardware_concurrency());
+	for (int run = 0; run < 2; run++) {
+		EntitySystem entities(&pWorld, 60.0f, 8);
+		entities.setThreadCount(run == 0 ? 1 : threads);
+		for (int i = 0; i < pCount; i++) {
+			entities.spawn(positions[i], velocities[i], glm::vec3(0.3f) * voxelSize);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < pTicks; i++) {
+			entities.tick();
+		}
+		double duration = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		std::cout << entities.getThreadCount() << " thread(s): " << duration / pTicks * 1000.0 << " ms per tick, "
+			<< (double)pCount * pTicks / duration / 1000000.0 << " million entity updates per second\n";
+	}
+	std::cout << std::flush;
+}
+
+void Benchmark::spatialHash(World& pWorld, int pQueries) {
+	// Entities spread over the same area each time, so the density grows with the count
+	float voxelSize = pWorld.getVoxelSize();
+	float radius = 4.0f * voxelSize;
+	std::vector<glm::vec3> centres(pQueries);
+	for (int i = 0; i < pQueries; i++) {
+		centres[i] = glm::vec3(Random::range(-128, 127), Random::range(0, 31), Random::range(-128, 127)) * voxelSize;
+	}
+
+	std::cout << "Spatial hash (" << pQueries << " queries, radius " << radius / voxelSize << " voxels)\n";
+	int counts[] = { 1000, 10000, 100000 };
+	for (int count : counts) {
+		std::vector<glm::vec3> positions(count);
+		for (int i = 0; i < count; i++) {
+			positions[i] = glm::vec3(Random::range(-1280, 1279), Random::range(0, 319), Random::range(-1280, 1279)) * voxelSize * 0.1f;
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		SpatialHash hash(&pWorld, 8);
+		for (int i = 0; i < count; i++) {
+			hash.insert(i, positions[i]);
+		}
+		auto middle = std::chrono::high_resolution_clock::now();
+
+		// Everything moves a little, like a tick of the entity system
+		for (int i = 0; i < count; i++) {
+			hash.move(i, positions[i] + glm::vec3(0.05f) * voxelSize);
+			hash.move(i, positions[i]);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double buildTime = std::chrono::duration<double>(middle - start).count();
+		double moveTime = std::chrono::duration<double>(end - middle).count() * 0.5;
+
+		std::vector<int> results;
+		size_t found = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for (glm::vec3 centre : centres) {
+			results.clear();
+			hash.queryRadius(centre, radius, results);
+			found += results.size();
+		}
+		double hashTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		// Checking every entity is what the hash replaces
+		size_t linearFound = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for (glm::vec3 centre : centres) {
+			for (glm::vec3 position : positions) {
+				glm::vec3 offset = position - centre;
+				if (glm::dot(offset, offset) <= radius * radius) linearFound++;
+			}
+		}
+		double linearTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		if (found != linearFound) std::cout << "[ERROR] Spatial hash found " << found << " entities instead of " << linearFound << "." << std::endl;
+		std::cout << count << " entities: build " << buildTime * 1000.0 << " ms, move " << moveTime * 1000.0 << " ms, "
+			<< pQueries / hashTime << " queries per second (linear " << pQueries / linearTime << "), "
+			<< (double)found / pQueries << " found per query\n";
+	}
+	std::cout << std::flush;
+}
+
+void Benchmark::lighting(World& pWorld) {
+	LightEngine& lighting = pWorld.getLighting();
+	int threadCount = lighting.getThreadCount();
+	int threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	// Light every chunk from scratch, on one thread and on all of them
+	std::cout << "Lighting (" << pWorld.getChunks().size() << " chunks)\n";
+	for (int run = 0; run < 2; run++) {
+		lighting.setThreadCount(run == 0 ? 1 : threads);
+		lighting.relightAll();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		lighting.update();
+		double duration = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		std::cout << "Whole world, " << lighting.getThreadCount() << " thread(s): " << duration * 1000.0 << " ms\n";
+	}
+	lighting.setThreadCount(threadCount);
+
+	// Find the ground in the middle of the terrain
+	glm::ivec3 ground(16, 64, 16);
+	while (ground.y > -64 && pWorld.getBlock(ground) == 0) ground.y--;
+	if (pWorld.getBlock(ground) == 0) {
+		std::cout << "[ERROR] Lighting benchmark couldn't find the ground." << std::endl;
+		return;
+	}
+
+	// Single edits, each relit on its own like between two frames
+	std::uint8_t groundId = pWorld.getBlock(ground);
+	struct LightEdit {
+		const char* name;
+		glm::ivec3 voxel;
+		std::uint8_t id;
+	};
+	LightEdit edits[] = {
+		{ "Place lamp", ground + glm::ivec3(0, 1, 0), 3 },
+		{ "Remove lamp", ground + glm::ivec3(0, 1, 0), 0 },
+		{ "Dig into the ground", ground, 0 },
+		{ "Fill the hole", ground, groundId }
+	};
+	for (const LightEdit& edit : edits) {
+		auto start = std::chrono::high_resolution_clock::now();
+		pWorld.setBlock(edit.voxel, edit.id);
+		lighting.update();
+		double duration = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		std::cout << edit.name << ": " << duration * 1000.0 << " ms, " << lighting.getLastNodeCount() << " voxels\n";
+	}
+	std::cout << std::flush;
+}
\ No newline at end of file
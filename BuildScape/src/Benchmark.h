@@ -0,0 +1,15 @@
+#pragma once
+
+#include "World.h"
+
+class Benchmark {
+public:
+	Benchmark() = delete;
+
+	static void chunkLoading(World& pWorld, int pRepetitions);
+	static void chunkCompression(World& pWorld, int pRepetitions);
+	static void blockEdits(World& pWorld, int pSize);
+	static void entities(World& pWorld, int pCount, int pTicks);
+	static void spatialHash(World& pWorld, int pQueries);
+	static void lighting(World& pWorld);
+};
\ No newline at end of file
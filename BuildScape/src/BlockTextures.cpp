@@ -0,0 +1,275 @@
+#include "BlockTextures.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "stb_image/stb_image.h"
+
+const int BlockTextures::TEXTURE_SIZE;
+const int BlockTextures::MAX_LAYERS;
+
+static const size_t LAYER_BYTES = BlockTextures::TEXTURE_SIZE * BlockTextures::TEXTURE_SIZE * 4;
+
+static double millisecondsSince(std::chrono::high_resolution_clock::time_point pStart) {
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - pStart).count() * 1000.0;
+}
+
+BlockTextures::BlockTextures()
+	: layerCount(1), textureArray(0), layerTable(0), pixelBuffer(0), tableDirty(true), nextTexture(0), decodedTextures(0), mappedPixels(nullptr),
+	loading(false), loadTime(0.0), uploadTime(0.0)
+{
+	threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	std::memset(faceLayers, 0, sizeof(faceLayers));
+}
+
+BlockTextures::~BlockTextures() {
+	destroy();
+}
+
+int BlockTextures::addTexture(const std::string& pPath) {
+	if (loading) {
+		std::cout << "[ERROR] Can't add texture " << pPath << " while the textures are loading" << std::endl;
+		return 0;
+	}
+
+	if (layerCount >= MAX_LAYERS) {
+		std::cout << "[ERROR] No texture layers left for " << pPath << std::endl;
+		return 0;
+	}
+
+	// The layer is reserved now and filled when the textures are loaded
+	paths.push_back(pPath);
+	return layerCount++;
+}
+
+void BlockTextures::setBlock(std::uint8_t pId, int pLayer) {
+	for (int dir = 0; dir < 6; dir++) setFace(pId, dir, pLayer);
+}
+
+void BlockTextures::setFace(std::uint8_t pId, int pDir, int pLayer) {
+	if (pLayer < 0 || pLayer >= layerCount) {
+		std::cout << "[ERROR] Texture layer " << pLayer << " doesn't exist" << std::endl;
+		return;
+	}
+
+	faceLayers[pId * 6 + pDir] = (std::uint8_t)pLayer;
+	tableDirty = true;
+}
+
+int BlockTextures::getLayer(std::uint8_t pId, int pDir) {
+	return faceLayers[pId * 6 + pDir];
+}
+
+void BlockTextures::load() {
+	if (loading) return;
+	loadStart = std::chrono::high_resolution_clock::now();
+
+	if (!textureArray) {
+		glGenTextures(1, &textureArray);
+		glGenTextures(1, &layerTable);
+	}
+
+	// Workers decode straight into the pixel buffer, the upload then doesn't need another copy
+	size_t size = layerCount * LAYER_BYTES;
+	glGenBuffers(1, &pixelBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	mappedPixels = (std::uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (!mappedPixels) {
+		std::cout << "[ERROR] Failed to map the texture pixel buffer, decoding into memory instead" << std::endl;
+		glDeleteBuffers(1, &pixelBuffer);
+		pixelBuffer = 0;
+		stagingPixels.resize(size);
+		mappedPixels = stagingPixels.data();
+	}
+
+	// Layer 0 is left empty for faces without a texture
+	std::memset(mappedPixels, 0, LAYER_BYTES);
+
+	timings.assign(paths.size(), TextureTiming());
+	nextTexture = 0;
+	decodedTextures = 0;
+	loading = true;
+
+	int threads = std::min(threadCount, (int)paths.size());
+	for (int i = 0; i < threads; i++) {
+		workers.emplace_back(&BlockTextures::decodeTextures, this);
+	}
+}
+
+void BlockTextures::decodeTextures() {
+	for (int i = nextTexture++; i < (int)paths.size(); i = nextTexture++) {
+		TextureTiming& timing = timings[i];
+		timing.path = paths[i];
+		timing.loaded = false;
+		timing.error.clear();
+		std::uint8_t* layer = mappedPixels + (i + 1) * LAYER_BYTES;
+
+		// Read the whole file first, so reading and decoding are timed apart
+		auto start = std::chrono::high_resolution_clock::now();
+		std::ifstream file(paths[i], std::ios::binary);
+		std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		timing.readTime = millisecondsSince(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		int width = 0, height = 0, channels;
+		unsigned char* data = bytes.empty() ? nullptr : stbi_load_from_memory(bytes.data(), (int)bytes.size(), &width, &height, &channels, 4);
+		timing.decodeTime = millisecondsSince(start);
+
+		// All layers of an array have the same size, anything else is left empty
+		if (data && width == TEXTURE_SIZE && height == TEXTURE_SIZE) {
+			std::memcpy(layer, data, LAYER_BYTES);
+			timing.loaded = true;
+		} else {
+			std::memset(layer, 0, LAYER_BYTES);
+			if (bytes.empty()) timing.error = "the file could not be read";
+			else if (!data) timing.error = std::string("it could not be decoded (") + stbi_failure_reason() + ")";
+			else timing.error = "it is " + std::to_string(width) + "x" + std::to_string(height) + ", block textures have to be "
+				+ std::to_string(TEXTURE_SIZE) + "x" + std::to_string(TEXTURE_SIZE);
+		}
+		if (data) stbi_image_free(data);
+		decodedTextures++;
+	}
+}
+
+void BlockTextures::finishLoading() {
+	if (!loading) return;
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+
+	auto start = std::chrono::high_resolution_clock::now();
+	const void* pixels = stagingPixels.empty() ? nullptr : stagingPixels.data();
+	if (pixelBuffer) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+		if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+			std::cout << "[ERROR] Texture pixel buffer was lost while decoding" << std::endl;
+		}
+	}
+	mappedPixels = nullptr;
+
+	// Nearest filtering keeps the pixel look up close, mipmaps stop the shimmering further away.
+	// With the pixel buffer bound, the upload reads from it instead of from memory.
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, TEXTURE_SIZE, TEXTURE_SIZE, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	if (pixelBuffer) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &pixelBuffer);
+		pixelBuffer = 0;
+	}
+	stagingPixels.clear();
+	stagingPixels.shrink_to_fit();
+
+	uploadTime = millisecondsSince(start);
+	loadTime = millisecondsSince(loadStart);
+	loading = false;
+
+	// Faces of textures that failed go back to the corner colours
+	for (size_t i = 0; i < timings.size(); i++) {
+		const TextureTiming& timing = timings[i];
+		if (!timing.loaded) {
+			std::cout << "[ERROR] Failed to load texture " << timing.path << ", " << timing.error << std::endl;
+			for (std::uint8_t& layer : faceLayers) {
+				if (layer == i + 1) layer = 0;
+			}
+			tableDirty = true;
+			continue;
+		}
+		std::cout << "Texture " << timing.path << ": read " << timing.readTime << " ms, decode " << timing.decodeTime << " ms\n";
+	}
+	std::cout << "Textures: " << layerCount - 1 << " loaded in " << loadTime << " ms, upload " << uploadTime << " ms\n";
+
+	uploadLayerTable();
+}
+
+bool BlockTextures::isLoading() {
+	return loading;
+}
+
+bool BlockTextures::isDecoded() {
+	return loading && decodedTextures == (int)paths.size();
+}
+
+void BlockTextures::uploadLayerTable() {
+	if (!layerTable) return;
+
+	// The shader looks up the layer with the face direction and block id, rows are 6 bytes so they're not aligned
+	glBindTexture(GL_TEXTURE_2D, layerTable);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, 6, 256, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, faceLayers);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	tableDirty = false;
+}
+
+void BlockTextures::bind(GLuint pShaderProgram) {
+	// Textures that are still loading are waited for, the first frame needs them
+	if (loading) finishLoading();
+	if (tableDirty) uploadLayerTable();
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, layerTable);
+	glActiveTexture(GL_TEXTURE0);
+
+	glUniform1i(glGetUniformLocation(pShaderProgram, "blockTextures"), 1);
+	glUniform1i(glGetUniformLocation(pShaderProgram, "faceLayers"), 2);
+}
+
+void BlockTextures::destroy() {
+	finishLoading();
+	if (!textureArray) return;
+
+	glDeleteTextures(1, &textureArray);
+	glDeleteTextures(1, &layerTable);
+	textureArray = 0;
+	layerTable = 0;
+	tableDirty = true;
+}
+
+void BlockTextures::setThreadCount(int pThreads) {
+	threadCount = std::max(1, pThreads);
+}
+
+int BlockTextures::getThreadCount() {
+	return threadCount;
+}
+
+int BlockTextures::getLayerCount() {
+	return layerCount;
+}
+
+size_t BlockTextures::getMemoryUsage() {
+	// Mipmaps add about a third
+	return layerCount * LAYER_BYTES * 4 / 3 + sizeof(faceLayers);
+}
+
+const std::vector<TextureTiming>& BlockTextures::getTimings() {
+	return timings;
+}
+
+double BlockTextures::getLoadTime() {
+	return loadTime;
+}
+
+double BlockTextures::getUploadTime() {
+	return uploadTime;
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GL/glew.h"
+
+// Time spent on one texture file while loading
+struct TextureTiming {
+	std::string path;
+	double readTime;
+	double decodeTime;
+	bool loaded;
+	// Why the texture failed to load, empty when it loaded
+	std::string error;
+};
+
+// Block face textures, stored as the layers of one texture array so chunks are still drawn with a single bind.
+// Every block id and face direction maps to a layer. Layer 0 is no texture, those faces keep the corner colours.
+// Quads tile their texture by voxel, so larger quads repeat it instead of sampling outside of it.
+//
+// Textures are decoded on worker threads straight into a mapped pixel unpack buffer,
+// so the main thread can generate the world in the meantime. Once isDecoded() returns true,
+// finishLoading() uploads them and generates the mipmaps without waiting for the workers.
+class BlockTextures {
+public:
+	BlockTextures();
+	~BlockTextures();
+	BlockTextures(const BlockTextures&) = delete;
+	BlockTextures& operator=(const BlockTextures&) = delete;
+
+	int addTexture(const std::string& pPath);
+	void setBlock(std::uint8_t pId, int pLayer);
+	void setFace(std::uint8_t pId, int pDir, int pLayer);
+	int getLayer(std::uint8_t pId, int pDir);
+
+	void load();
+	void finishLoading();
+	bool isLoading();
+	bool isDecoded();
+
+	void bind(GLuint pShaderProgram);
+	void destroy();
+
+	void setThreadCount(int pThreads);
+	int getThreadCount();
+	int getLayerCount();
+	size_t getMemoryUsage();
+	const std::vector<TextureTiming>& getTimings();
+	double getLoadTime();
+	double getUploadTime();
+
+	static const int TEXTURE_SIZE = 16;
+	static const int MAX_LAYERS = 256;
+
+private:
+	void decodeTextures();
+	void uploadLayerTable();
+
+	// Files of the layers after layer 0, in order
+	std::vector<std::string> paths;
+	std::vector<TextureTiming> timings;
+	int layerCount;
+
+	// Layer of each face, 6 directions per block id
+	std::uint8_t faceLayers[256 * 6];
+
+	GLuint textureArray;
+	GLuint layerTable;
+	GLuint pixelBuffer;
+	bool tableDirty;
+
+	// Decoding, workers write the layers into the mapped buffer, or into the staging pixels when mapping failed
+	std::vector<std::thread> workers;
+	std::atomic<int> nextTexture;
+	std::atomic<int> decodedTextures;
+	std::uint8_t* mappedPixels;
+	std::vector<std::uint8_t> stagingPixels;
+	int threadCount;
+	bool loading;
+	std::chrono::high_resolution_clock::time_point loadStart;
+	double loadTime;
+	double uploadTime;
+};
\ No newline at end of file
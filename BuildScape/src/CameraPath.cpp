@@ -0,0 +1,97 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+CameraPath::CameraPath() {
+
+}
+
+bool CameraPath::load(const std::string& pPath) {
+	std::ifstream file(pPath);
+	if (!file) {
+		std::cout << "[ERROR] Failed to open camera path " << pPath << std::endl;
+		return false;
+	}
+
+	keyframes.clear();
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#') continue;
+
+		CameraKeyframe keyframe;
+		std::istringstream stream(line);
+		if (!(stream >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >> keyframe.yaw >> keyframe.pitch)) {
+			std::cout << "[ERROR] Camera path " << pPath << " line " << lineNumber << " isn't \"time x y z yaw pitch\"" << std::endl;
+			keyframes.clear();
+			return false;
+		}
+		addKeyframe(keyframe);
+	}
+
+	if (keyframes.empty()) {
+		std::cout << "[ERROR] Camera path " << pPath << " has no keyframes" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void CameraPath::addKeyframe(const CameraKeyframe& pKeyframe) {
+	auto position = std::upper_bound(keyframes.begin(), keyframes.end(), pKeyframe.time, [](float pValue, const CameraKeyframe& pOther) {
+		return pValue < pOther.time;
+	});
+	keyframes.insert(position, pKeyframe);
+}
+
+CameraKeyframe CameraPath::sample(float pTime) {
+	if (keyframes.empty()) return CameraKeyframe{ pTime, glm::vec3(0.0f), 0.0f, 0.0f };
+
+	// Before the first and after the last keyframe the camera stands still
+	if (pTime <= keyframes.front().time) return keyframes.front();
+	if (pTime >= keyframes.back().time) return keyframes.back();
+
+	auto next = std::upper_bound(keyframes.begin(), keyframes.end(), pTime, [](float pValue, const CameraKeyframe& pOther) {
+		return pValue < pOther.time;
+	});
+	const CameraKeyframe& from = *(next - 1);
+	const CameraKeyframe& to = *next;
+	float t = to.time > from.time ? (pTime - from.time) / (to.time - from.time) : 1.0f;
+
+	CameraKeyframe keyframe;
+	keyframe.time = pTime;
+	keyframe.position = glm::mix(from.position, to.position, t);
+	keyframe.yaw = glm::mix(from.yaw, to.yaw, t);
+	keyframe.pitch = glm::mix(from.pitch, to.pitch, t);
+	return keyframe;
+}
+
+std::vector<float> CameraPath::getSampleTimes(float pTimestep) {
+	// Every step of the timestep, with the keyframes themselves in between
+	std::vector<float> times;
+	float duration = getDuration();
+	for (int step = 0; step * pTimestep <= duration; step++) {
+		times.push_back(step * pTimestep);
+	}
+	for (const CameraKeyframe& keyframe : keyframes) {
+		times.push_back(keyframe.time);
+	}
+
+	std::sort(times.begin(), times.end());
+	times.erase(std::unique(times.begin(), times.end(), [](float a, float b) {
+		return b - a < 0.00001f;
+	}), times.end());
+	return times;
+}
+
+float CameraPath::getDuration() {
+	return keyframes.empty() ? 0.0f : keyframes.back().time;
+}
+
+int CameraPath::getKeyframeCount() {
+	return (int)keyframes.size();
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// Camera position and direction at a point in time, yaw and pitch in degrees like the camera uses them
+struct CameraKeyframe {
+	float time;
+	glm::vec3 position;
+	float yaw;
+	float pitch;
+};
+
+// Scripted camera movement, read from a text file with one keyframe per line: time x y z yaw pitch.
+// Empty lines and lines starting with # are skipped. The camera moves in a straight line between keyframes.
+class CameraPath {
+public:
+	CameraPath();
+
+	bool load(const std::string& pPath);
+	void addKeyframe(const CameraKeyframe& pKeyframe);
+	CameraKeyframe sample(float pTime);
+	std::vector<float> getSampleTimes(float pTimestep);
+
+	float getDuration();
+	int getKeyframeCount();
+
+private:
+	// Sorted by time
+	std::vector<CameraKeyframe> keyframes;
+};
\ No newline at end of file
@@ -1,87 +1,394 @@
 #include "Chunk.h"
 
-Chunk::Chunk(int pX, int pY, int pZ, bool pEmpty) 
-	: position(glm::vec3(pX, pY, pZ)), empty(pEmpty) 
+#include "ChunkCodec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+template <int SizeX, int SizeY, int SizeZ>
+int BasicChunk<SizeX, SizeY, SizeZ>::decompressCount = 0;
+
+template <int SizeX, int SizeY, int SizeZ>
+double BasicChunk<SizeX, SizeY, SizeZ>::decompressTime = 0.0;
+
+template <int SizeX, int SizeY, int SizeZ>
+std::mutex BasicChunk<SizeX, SizeY, SizeZ>::decompressMutex;
+
+template <int SizeX, int SizeY, int SizeZ>
+BasicChunk<SizeX, SizeY, SizeZ>::BasicChunk(int pX, int pY, int pZ, glm::vec3 pSize, bool pEmpty) 
+	: position(glm::vec3(pX, pY, pZ) * pSize), coordinates(glm::ivec3(pX, pY, pZ)), empty(pEmpty) 
 {
 
 }
 
-Chunk::~Chunk() {
+template <int SizeX, int SizeY, int SizeZ>
+BasicChunk<SizeX, SizeY, SizeZ>::~BasicChunk() {
 
 }
 
-void Chunk::addBlock(std::uint32_t pBlock) {
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::addBlock(std::uint32_t pBlock) {
 	blocks.push_back(pBlock);
 }
 
-glm::vec3 Chunk::getPosition() {
+template <int SizeX, int SizeY, int SizeZ>
+glm::vec3 BasicChunk<SizeX, SizeY, SizeZ>::getPosition() {
 	return position;
 }
 
-bool Chunk::operator==(const Chunk& pChunk) {
+template <int SizeX, int SizeY, int SizeZ>
+glm::ivec3 BasicChunk<SizeX, SizeY, SizeZ>::getCoordinates() {
+	return coordinates;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::operator==(const BasicChunk& pChunk) {
 	return (position == pChunk.position);
 }
 
-bool Chunk::operator!=(const Chunk& pChunk) {
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::operator!=(const BasicChunk& pChunk) {
 	return (position != pChunk.position);
 }
 
-void Chunk::setIgnoreLeft(bool pIgnore) {
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setIgnoreLeft(bool pIgnore) {
 	ignoreLeft = pIgnore;
 }
 
-void Chunk::setIgnoreRight(bool pIgnore) {
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setIgnoreRight(bool pIgnore) {
 	ignoreRight = pIgnore;
 }
 
-void Chunk::setIgnoreDown(bool pIgnore) {
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setIgnoreDown(bool pIgnore) {
 	ignoreDown = pIgnore;
 }
 
-void Chunk::setIgnoreUp(bool pIgnore) {
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setIgnoreUp(bool pIgnore) {
 	ignoreUp = pIgnore;
 }
 
-void Chunk::setIgnoreFront(bool pIgnore) {
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setIgnoreFront(bool pIgnore) {
 	ignoreFront = pIgnore;
 }
 
-void Chunk::setIgnoreBack(bool pIgnore) {
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setIgnoreBack(bool pIgnore) {
 	ignoreBack = pIgnore;
 }
 
-bool Chunk::getIgnoreLeft() {
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::getIgnoreLeft() {
 	return ignoreLeft;
 }
 
-bool Chunk::getIgnoreRight() {
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::getIgnoreRight() {
 	return ignoreRight;
 }
 
-bool Chunk::getIgnoreDown() {
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::getIgnoreDown() {
 	return ignoreDown;
 }
 
-bool Chunk::getIgnoreUp() {
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::getIgnoreUp() {
 	return ignoreUp;
 }
 
-bool Chunk::getIgnoreFront() {
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::getIgnoreFront() {
 	return ignoreFront;
 }
 
-bool Chunk::getIgnoreBack() {
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::getIgnoreBack() {
 	return ignoreBack;
 }
 
-void Chunk::setEmpty(bool pEmpty) {
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setEmpty(bool pEmpty) {
 	empty = pEmpty;
 }
 
-bool Chunk::isEmpty() {
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::isEmpty() {
 	return empty;
 }
 
-std::vector<std::uint32_t>& Chunk::getBlocks() {
+template <int SizeX, int SizeY, int SizeZ>
+std::vector<std::uint32_t>& BasicChunk<SizeX, SizeY, SizeZ>::getBlocks() {
+	if (compressed) {
+		std::lock_guard<std::mutex> lock(decompressMutex);
+		if (compressed) decompress();
+	}
 	return blocks;
-}
\ No newline at end of file
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setDirty(bool pDirty) {
+	dirty = pDirty;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::isDirty() {
+	return dirty;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setMeshDirty(bool pDirty) {
+	meshDirty = pDirty;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::isMeshDirty() {
+	return meshDirty;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+ChunkMesh& BasicChunk<SizeX, SizeY, SizeZ>::getMesh() {
+	return mesh;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::encode(std::vector<std::uint8_t>& pData) {
+	pData.clear();
+
+	// Empty chunks only store their encoding
+	if (empty) {
+		pData.push_back(0);
+		return;
+	}
+
+	// Only the ids are stored, compressed with the chunk codec after the chunk's dimensions
+	pData.push_back(3);
+	pData.push_back((std::uint8_t)SizeX);
+	pData.push_back((std::uint8_t)SizeY);
+	pData.push_back((std::uint8_t)SizeZ);
+
+	// Cold chunks already hold the ids compressed the same way, they're copied without decompressing the chunk
+	{
+		std::lock_guard<std::mutex> lock(decompressMutex);
+		if (compressed) {
+			std::uint32_t idSize;
+			memcpy(&idSize, compressedBlocks.data(), sizeof(idSize));
+			const std::uint8_t* data = compressedBlocks.data() + sizeof(idSize);
+			pData.insert(pData.end(), data, data + idSize);
+			return;
+		}
+	}
+
+	if (blocks.empty()) {
+		pData.assign(1, 0);
+		return;
+	}
+
+	std::vector<std::uint8_t> ids(VOLUME);
+	for (int i = 0; i < VOLUME; i++) {
+		ids[i] = (blocks[i] >> 12) & 0xFF;
+	}
+
+	std::vector<std::uint8_t> compressedIds;
+	ChunkCodec::compress(ids.data(), VOLUME, ROW, LAYER, compressedIds);
+	pData.insert(pData.end(), compressedIds.begin(), compressedIds.end());
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::decode(const std::uint8_t* pData, size_t pSize) {
+	blocks.clear();
+	compressedBlocks.clear();
+	compressed = false;
+	if (pSize == 0) return false;
+
+	if (pData[0] == 0) {
+		empty = true;
+		return true;
+	}
+
+	// Older saves have no dimensions and always hold 16x16x16 chunks
+	bool legacy = pData[0] == 1 || pData[0] == 2;
+	if (legacy && VOLUME != 4096) return false;
+	if (pData[0] == 3 && (pSize < 4 || pData[1] != SizeX || pData[2] != SizeY || pData[3] != SizeZ)) return false;
+
+	std::vector<std::uint8_t> ids(VOLUME);
+	if (pData[0] == 1) {
+		// Runs of (id, length)
+		int count = 0;
+		for (size_t i = 1; i + 2 < pSize; i += 3) {
+			int run = pData[i + 1] | (pData[i + 2] << 8);
+			for (int j = 0; j < run && count < VOLUME; j++) {
+				ids[count++] = pData[i];
+			}
+		}
+		if (count != VOLUME) return false;
+	} else if (pData[0] == 2) {
+		if (!ChunkCodec::decompress(pData + 1, pSize - 1, ids.data(), VOLUME)) return false;
+	} else if (pData[0] != 3 || !ChunkCodec::decompress(pData + 4, pSize - 4, ids.data(), VOLUME)) {
+		return false;
+	}
+
+	setBlocks(ids.data(), nullptr);
+	empty = false;
+	return true;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::compress() {
+	if (compressed || (int)blocks.size() != VOLUME) return;
+
+	// Face bits are kept as well, so the blocks come back exactly as they were
+	std::vector<std::uint8_t> ids(VOLUME);
+	std::vector<std::uint8_t> faces(VOLUME);
+	for (int i = 0; i < VOLUME; i++) {
+		ids[i] = (blocks[i] >> 12) & 0xFF;
+		faces[i] = (blocks[i] >> 6) & 0x3F;
+	}
+
+	std::vector<std::uint8_t> faceData;
+	ChunkCodec::compress(ids.data(), VOLUME, ROW, LAYER, compressedBlocks);
+	ChunkCodec::compress(faces.data(), VOLUME, ROW, LAYER, faceData);
+
+	// The face data goes after the ids, prefixed with the size of the ids
+	std::uint32_t idSize = (std::uint32_t)compressedBlocks.size();
+	compressedBlocks.insert(compressedBlocks.begin(), (std::uint8_t*)&idSize, (std::uint8_t*)&idSize + sizeof(idSize));
+	compressedBlocks.insert(compressedBlocks.end(), faceData.begin(), faceData.end());
+	compressedBlocks.shrink_to_fit();
+
+	std::vector<std::uint32_t>().swap(blocks);
+	compressed = true;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::decompress() {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::uint32_t idSize = 0;
+	size_t size = compressedBlocks.size() >= sizeof(idSize) ? compressedBlocks.size() - sizeof(idSize) : 0;
+	if (size > 0) memcpy(&idSize, compressedBlocks.data(), sizeof(idSize));
+	const std::uint8_t* data = compressedBlocks.data() + sizeof(idSize);
+
+	std::vector<std::uint8_t> ids(VOLUME);
+	std::vector<std::uint8_t> faces(VOLUME);
+	bool valid = size > 0 && idSize <= size
+		&& ChunkCodec::decompress(data, idSize, ids.data(), VOLUME)
+		&& ChunkCodec::decompress(data + idSize, size - idSize, faces.data(), VOLUME);
+
+	// The chunk is left as air and isn't saved, so the copy on disk stays as it was
+	if (!valid) {
+		std::cout << "[ERROR] Compressed blocks of chunk " << coordinates.x << ", " << coordinates.y << ", " << coordinates.z << " could not be decompressed." << std::endl;
+		std::fill(ids.begin(), ids.end(), 0);
+		std::fill(faces.begin(), faces.end(), 0);
+		empty = true;
+		dirty = false;
+	}
+	setBlocks(ids.data(), faces.data());
+
+	decompressCount++;
+	decompressTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setBlocks(const std::uint8_t* pIds, const std::uint8_t* pFaces) {
+	blocks.resize(VOLUME);
+	for (int index = 0; index < VOLUME; index++) {
+		std::uint32_t block = (std::uint32_t)pIds[index] << 12;
+		if (pFaces) block |= ((std::uint32_t)pFaces[index] << 6);
+		blocks[index] = block;
+	}
+
+	// The blocks are complete before other threads see the chunk as decompressed
+	std::vector<std::uint8_t>().swap(compressedBlocks);
+	compressed = false;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::isCompressed() {
+	return compressed;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::readCompressedIds(std::vector<std::uint8_t>& pIds) {
+	// Only the ids are decompressed, into the given buffer, the chunk itself stays compressed
+	std::lock_guard<std::mutex> lock(decompressMutex);
+	if (!compressed || compressedBlocks.size() < sizeof(std::uint32_t)) return false;
+
+	std::uint32_t idSize;
+	memcpy(&idSize, compressedBlocks.data(), sizeof(idSize));
+	if (idSize > compressedBlocks.size() - sizeof(idSize)) return false;
+
+	pIds.resize(VOLUME);
+	return ChunkCodec::decompress(compressedBlocks.data() + sizeof(idSize), idSize, pIds.data(), VOLUME);
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+int BasicChunk<SizeX, SizeY, SizeZ>::getDecompressCount() {
+	return decompressCount;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+double BasicChunk<SizeX, SizeY, SizeZ>::getDecompressTime() {
+	return decompressTime;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+std::uint8_t BasicChunk<SizeX, SizeY, SizeZ>::getLight(int pIndex) {
+	return light.empty() ? uniformLight : light[pIndex];
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setLight(int pIndex, std::uint8_t pLight) {
+	if (light.empty()) {
+		if (pLight == uniformLight) return;
+		light.assign(VOLUME, uniformLight);
+	}
+	light[pIndex] = pLight;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::fillLight(std::uint8_t pLight) {
+	light.clear();
+	light.shrink_to_fit();
+	uniformLight = pLight;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::compactLight() {
+	// Chunks in open air or deep underground usually end up with a single value
+	if (light.empty()) return;
+	for (std::uint8_t value : light) {
+		if (value != light[0]) return;
+	}
+	fillLight(light[0]);
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+bool BasicChunk<SizeX, SizeY, SizeZ>::isLightUniform() {
+	return light.empty();
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+void BasicChunk<SizeX, SizeY, SizeZ>::setLastVisible(float pTime) {
+	lastVisible = pTime;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+float BasicChunk<SizeX, SizeY, SizeZ>::getLastVisible() {
+	return lastVisible;
+}
+
+template <int SizeX, int SizeY, int SizeZ>
+size_t BasicChunk<SizeX, SizeY, SizeZ>::getMemoryUsage() {
+	return sizeof(BasicChunk) + blocks.capacity() * sizeof(std::uint32_t) + compressedBlocks.capacity() + light.capacity();
+}
+
+// Chunk sizes that can be picked with CHUNK_SIZE
+template class BasicChunk<16, 16, 16>;
+template class BasicChunk<32, 32, 32>;
+template class BasicChunk<64, 64, 64>;
\ No newline at end of file
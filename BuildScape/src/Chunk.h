@@ -2,18 +2,46 @@
 
 #include <glm/glm.hpp>
 
+#include "ChunkMesh.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <vector>
 
-class Chunk {
+// Chunk dimensions used by the game, build with CHUNK_SIZE set to 32 or 64 to compare other sizes
+#ifndef CHUNK_SIZE
+#define CHUNK_SIZE 16
+#endif
+
+// A chunk of SizeX * SizeY * SizeZ blocks, stored Y-major: x changes fastest, then z, then y.
+// Block positions follow from their index, so blocks only store their id and face bits.
+template <int SizeX, int SizeY, int SizeZ>
+class BasicChunk {
 public:
-	Chunk(int pX, int pY, int pZ, bool pEmpty);
-	~Chunk();
+	static_assert(SizeX > 0 && SizeX <= 64 && SizeY > 0 && SizeY <= 64 && SizeZ > 0 && SizeZ <= 64, "Chunks can be at most 64 blocks along each axis");
+
+	static constexpr int SIZE_X = SizeX;
+	static constexpr int SIZE_Y = SizeY;
+	static constexpr int SIZE_Z = SizeZ;
+	static constexpr int ROW = SizeX;
+	static constexpr int LAYER = SizeX * SizeZ;
+	static constexpr int VOLUME = SizeX * SizeY * SizeZ;
+
+	static constexpr int getIndex(int pX, int pY, int pZ) { return pY * LAYER + pZ * ROW + pX; }
+	static constexpr int getX(int pIndex) { return pIndex % SizeX; }
+	static constexpr int getY(int pIndex) { return pIndex / LAYER; }
+	static constexpr int getZ(int pIndex) { return (pIndex / ROW) % SizeZ; }
+
+	BasicChunk(int pX, int pY, int pZ, glm::vec3 pSize, bool pEmpty);
+	~BasicChunk();
 
 	void addBlock(std::uint32_t pBlock);
 	glm::vec3 getPosition();
+	glm::ivec3 getCoordinates();
 
-	bool operator==(const Chunk& pChunk);
-	bool operator!=(const Chunk& pChunk);
+	bool operator==(const BasicChunk& pChunk);
+	bool operator!=(const BasicChunk& pChunk);
 
 	void setIgnoreLeft(bool pIgnore);
 	void setIgnoreRight(bool pIgnore);
@@ -32,12 +60,57 @@ public:
 	void setEmpty(bool pEmpty);
 	bool isEmpty();
 	std::vector<std::uint32_t>& getBlocks();
+	void setBlocks(const std::uint8_t* pIds, const std::uint8_t* pFaces);
+
+	void setDirty(bool pDirty);
+	bool isDirty();
+	void setMeshDirty(bool pDirty);
+	bool isMeshDirty();
+	ChunkMesh& getMesh();
+	void encode(std::vector<std::uint8_t>& pData);
+	bool decode(const std::uint8_t* pData, size_t pSize);
+
+	void compress();
+	bool isCompressed();
+	bool readCompressedIds(std::vector<std::uint8_t>& pIds);
+	static int getDecompressCount();
+	static double getDecompressTime();
+
+	// Sky light in the high four bits, block light in the low four
+	std::uint8_t getLight(int pIndex);
+	void setLight(int pIndex, std::uint8_t pLight);
+	void fillLight(std::uint8_t pLight);
+	void compactLight();
+	bool isLightUniform();
+
+	void setLastVisible(float pTime);
+	float getLastVisible();
+	size_t getMemoryUsage();
 
 private:
 	std::vector<std::uint32_t> blocks;
 	glm::vec3 position;
+	glm::ivec3 coordinates;
+	float lastVisible = 0.0f;
 
 	bool empty = true;
+	bool dirty = false;
+
+	// The mesh is rebuilt from the blocks when they change
+	ChunkMesh mesh;
+	bool meshDirty = true;
+
+	// Blocks of chunks that haven't been seen for a while are kept compressed
+	// Other threads may read the blocks, only one of them decompresses them
+	std::vector<std::uint8_t> compressedBlocks;
+	std::atomic<bool> compressed{ false };
+	static std::mutex decompressMutex;
+	static int decompressCount;
+	static double decompressTime;
+
+	// Chunks where every voxel has the same light only store that value
+	std::vector<std::uint8_t> light;
+	std::uint8_t uniformLight = 0;
 
 	bool ignoreLeft = false;
 	bool ignoreRight = false;
@@ -45,4 +118,15 @@ private:
 	bool ignoreUp = false;
 	bool ignoreFront = false;
 	bool ignoreBack = false;
-};
\ No newline at end of file
+
+	void decompress();
+};
+
+template <int SizeX, int SizeY, int SizeZ> constexpr int BasicChunk<SizeX, SizeY, SizeZ>::SIZE_X;
+template <int SizeX, int SizeY, int SizeZ> constexpr int BasicChunk<SizeX, SizeY, SizeZ>::SIZE_Y;
+template <int SizeX, int SizeY, int SizeZ> constexpr int BasicChunk<SizeX, SizeY, SizeZ>::SIZE_Z;
+template <int SizeX, int SizeY, int SizeZ> constexpr int BasicChunk<SizeX, SizeY, SizeZ>::ROW;
+template <int SizeX, int SizeY, int SizeZ> constexpr int BasicChunk<SizeX, SizeY, SizeZ>::LAYER;
+template <int SizeX, int SizeY, int SizeZ> constexpr int BasicChunk<SizeX, SizeY, SizeZ>::VOLUME;
+
+typedef BasicChunk<CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE> Chunk;
\ No newline at end of file
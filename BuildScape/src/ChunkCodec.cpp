@@ -0,0 +1,234 @@
+#include "ChunkCodec.h"
+
+#include <cstring>
+
+// Token types, stored in the top two bits of a token's first byte
+static const int tokenRun = 0;
+static const int tokenCopy = 1;
+static const int tokenLiteral = 2;
+
+// Shorter runs and copies are cheaper to store as literals
+static const int minRun = 3;
+static const int minCopy = 4;
+
+static int getBits(int pPaletteSize) {
+	int bits = 1;
+	while ((1 << bits) < pPaletteSize) bits++;
+	return bits;
+}
+
+static std::uint32_t hashIndices(const std::uint8_t* pIndices) {
+	std::uint32_t value = pIndices[0] | (pIndices[1] << 8) | (pIndices[2] << 16) | (pIndices[3] << 24);
+	return (value * 2654435761u) >> 20;
+}
+
+void ChunkCodec::compress(const std::uint8_t* pIds, int pCount, int pRowSize, int pLayerSize, std::vector<std::uint8_t>& pData) {
+	pData.clear();
+
+	// Build the palette and replace ids by their palette index
+	int paletteIndex[256];
+	memset(paletteIndex, -1, sizeof(paletteIndex));
+	std::vector<std::uint8_t> palette;
+	std::vector<std::uint8_t> indices(pCount);
+
+	for (int i = 0; i < pCount; i++) {
+		if (paletteIndex[pIds[i]] < 0) {
+			paletteIndex[pIds[i]] = (int)palette.size();
+			palette.push_back(pIds[i]);
+		}
+		indices[i] = (std::uint8_t)paletteIndex[pIds[i]];
+	}
+
+	pData.push_back((std::uint8_t)(palette.size() - 1));
+	pData.insert(pData.end(), palette.begin(), palette.end());
+
+	// A chunk of a single id is just its palette
+	if (palette.size() == 1) return;
+
+	int bits = getBits((int)palette.size());
+	const int offsets[] = { pRowSize, pLayerSize, pLayerSize + pRowSize, pLayerSize - pRowSize };
+
+	std::vector<int> lastPosition(4096, -1);
+	int literalStart = 0;
+	int i = 0;
+
+	while (i < pCount) {
+		// Length of the run starting here
+		int run = 1;
+		while (i + run < pCount && indices[i + run] == indices[i]) run++;
+
+		// Longest copy from the row or layer below, or the last place these four indices were seen
+		int copyLength = 0;
+		int copyOffset = 0;
+		int candidates[5];
+		int candidateCount = 0;
+		for (int offset : offsets) candidates[candidateCount++] = offset;
+
+		if (i + 4 <= pCount) {
+			std::uint32_t hash = hashIndices(&indices[i]);
+			if (lastPosition[hash] >= 0) candidates[candidateCount++] = i - lastPosition[hash];
+			lastPosition[hash] = i;
+		}
+
+		for (int c = 0; c < candidateCount; c++) {
+			int offset = candidates[c];
+			if (offset <= 0 || offset > i) continue;
+
+			int length = 0;
+			while (i + length < pCount && indices[i + length] == indices[i + length - offset]) length++;
+			if (length > copyLength) {
+				copyLength = length;
+				copyOffset = offset;
+			}
+		}
+
+		int length = 0;
+		if (run >= minRun && run >= copyLength) length = run;
+		else if (copyLength >= minCopy) length = copyLength;
+
+		if (length == 0) {
+			i++;
+			continue;
+		}
+
+		// Flush the literals in front of this token
+		if (literalStart < i) writeLiterals(pData, &indices[literalStart], i - literalStart, bits);
+
+		if (length == run) {
+			writeToken(pData, tokenRun, run);
+			pData.push_back(indices[i]);
+		} else {
+			writeToken(pData, tokenCopy, copyLength);
+			writeVarint(pData, (std::uint32_t)copyOffset);
+		}
+
+		i += length;
+		literalStart = i;
+	}
+
+	if (literalStart < pCount) writeLiterals(pData, &indices[literalStart], pCount - literalStart, bits);
+}
+
+bool ChunkCodec::decompress(const std::uint8_t* pData, size_t pSize, std::uint8_t* pIds, int pCount) {
+	const std::uint8_t* end = pData + pSize;
+	if (pSize == 0) return false;
+
+	int paletteSize = pData[0] + 1;
+	if (pSize < (size_t)paletteSize + 1) return false;
+
+	const std::uint8_t* palette = pData + 1;
+	pData += paletteSize + 1;
+
+	if (paletteSize == 1) {
+		memset(pIds, palette[0], pCount);
+		return true;
+	}
+
+	// Tokens are decoded into palette indices first
+	int bits = getBits(paletteSize);
+	int i = 0;
+	while (i < pCount) {
+		if (pData >= end) return false;
+
+		int type = *pData >> 6;
+		std::uint32_t length = *pData & 0x3F;
+		pData++;
+
+		if (length == 0x3F) {
+			if (!readVarint(pData, end, length)) return false;
+			length += 64;
+		} else {
+			length += 1;
+		}
+		if (length > (std::uint32_t)(pCount - i)) return false;
+
+		if (type == tokenRun) {
+			if (pData >= end) return false;
+			memset(pIds + i, *pData++, length);
+		} else if (type == tokenCopy) {
+			std::uint32_t offset;
+			if (!readVarint(pData, end, offset) || offset == 0 || offset > (std::uint32_t)i) return false;
+
+			// Copies may overlap themselves, so go forward one index at a time
+			for (std::uint32_t j = 0; j < length; j++) {
+				pIds[i + j] = pIds[i + j - offset];
+			}
+		} else if (type == tokenLiteral) {
+			size_t bytes = (length * bits + 7) / 8;
+			if ((size_t)(end - pData) < bytes) return false;
+
+			std::uint32_t buffer = 0;
+			int buffered = 0;
+			for (std::uint32_t j = 0; j < length; j++) {
+				while (buffered < bits) {
+					buffer |= (std::uint32_t)(*pData++) << buffered;
+					buffered += 8;
+				}
+				pIds[i + j] = buffer & ((1 << bits) - 1);
+				buffer >>= bits;
+				buffered -= bits;
+			}
+		} else {
+			return false;
+		}
+
+		i += length;
+	}
+
+	// Turn palette indices back into ids
+	for (int j = 0; j < pCount; j++) {
+		if (pIds[j] >= paletteSize) return false;
+		pIds[j] = palette[pIds[j]];
+	}
+	return true;
+}
+
+void ChunkCodec::writeToken(std::vector<std::uint8_t>& pData, int pType, int pLength) {
+	// Lengths up to 63 fit in the token itself
+	if (pLength <= 63) {
+		pData.push_back((std::uint8_t)((pType << 6) | (pLength - 1)));
+		return;
+	}
+
+	pData.push_back((std::uint8_t)((pType << 6) | 0x3F));
+	writeVarint(pData, (std::uint32_t)(pLength - 64));
+}
+
+void ChunkCodec::writeVarint(std::vector<std::uint8_t>& pData, std::uint32_t pValue) {
+	while (pValue >= 0x80) {
+		pData.push_back((std::uint8_t)(pValue | 0x80));
+		pValue >>= 7;
+	}
+	pData.push_back((std::uint8_t)pValue);
+}
+
+bool ChunkCodec::readVarint(const std::uint8_t*& pData, const std::uint8_t* pEnd, std::uint32_t& pValue) {
+	pValue = 0;
+	for (int shift = 0; shift < 32; shift += 7) {
+		if (pData >= pEnd) return false;
+
+		std::uint8_t byte = *pData++;
+		pValue |= (std::uint32_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) return true;
+	}
+	return false;
+}
+
+void ChunkCodec::writeLiterals(std::vector<std::uint8_t>& pData, const std::uint8_t* pIndices, int pCount, int pBits) {
+	writeToken(pData, tokenLiteral, pCount);
+
+	// Pack the indices with the least significant bits first
+	std::uint32_t buffer = 0;
+	int buffered = 0;
+	for (int i = 0; i < pCount; i++) {
+		buffer |= (std::uint32_t)pIndices[i] << buffered;
+		buffered += pBits;
+
+		while (buffered >= 8) {
+			pData.push_back(buffer & 0xFF);
+			buffer >>= 8;
+			buffered -= 8;
+		}
+	}
+	if (buffered > 0) pData.push_back(buffer & 0xFF);
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compression for the block ids of a chunk, stored in the chunk's Y-major index order.
+//
+// The ids are first replaced by indices into a palette of the ids the chunk uses. The indices are
+// then written as tokens: runs of a single index, copies of earlier indices (mostly the row or layer
+// below, which look alike in terrain) and literals that are bit-packed to the size of the palette.
+class ChunkCodec {
+public:
+	ChunkCodec() = delete;
+
+	static void compress(const std::uint8_t* pIds, int pCount, int pRowSize, int pLayerSize, std::vector<std::uint8_t>& pData);
+	static bool decompress(const std::uint8_t* pData, size_t pSize, std::uint8_t* pIds, int pCount);
+
+private:
+	static void writeToken(std::vector<std::uint8_t>& pData, int pType, int pLength);
+	static void writeVarint(std::vector<std::uint8_t>& pData, std::uint32_t pValue);
+	static bool readVarint(const std::uint8_t*& pData, const std::uint8_t* pEnd, std::uint32_t& pValue);
+	static void writeLiterals(std::vector<std::uint8_t>& pData, const std::uint8_t* pIndices, int pCount, int pBits);
+};
\ No newline at end of file
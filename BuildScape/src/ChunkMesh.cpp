@@ -0,0 +1,96 @@
+#include "ChunkMesh.h"
+
+ChunkMesh::ChunkMesh()
+	: VAO(0), VBO(0), EBO(0), bytes(0)
+{
+	for (int i = 0; i < 6; i++) {
+		sectionStarts[i] = 0;
+		sectionCounts[i] = 0;
+	}
+}
+
+ChunkMesh::~ChunkMesh() {
+	destroy();
+}
+
+void ChunkMesh::upload(const std::vector<ChunkVertex>& pVertices, const std::vector<GLuint>& pIndices, const int pSectionCounts[6]) {
+	// Generate buffers the first time
+	if (!VAO) {
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
+
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+		glVertexAttribIPointer(0, 2, GL_UNSIGNED_INT, sizeof(ChunkVertex), (void*)0);
+		glEnableVertexAttribArray(0);
+	} else {
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	}
+
+	glBufferData(GL_ARRAY_BUFFER, pVertices.size() * sizeof(ChunkVertex), pVertices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, pIndices.size() * sizeof(GLuint), pIndices.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+
+	// Remember where each direction's indices are
+	int start = 0;
+	for (int i = 0; i < 6; i++) {
+		sectionStarts[i] = start;
+		sectionCounts[i] = pSectionCounts[i];
+		start += pSectionCounts[i];
+	}
+
+	bytes = pVertices.size() * sizeof(ChunkVertex) + pIndices.size() * sizeof(GLuint);
+}
+
+int ChunkMesh::draw(const bool pSections[6]) {
+	if (!VAO) return 0;
+
+	glBindVertexArray(VAO);
+
+	// Neighbouring sections that are both drawn are drawn in one go
+	int drawn = 0;
+	int i = 0;
+	while (i < 6) {
+		if (!pSections[i]) {
+			i++;
+			continue;
+		}
+
+		int start = sectionStarts[i];
+		int count = 0;
+		while (i < 6 && pSections[i]) {
+			count += sectionCounts[i];
+			i++;
+		}
+
+		if (count > 0) glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)(start * sizeof(GLuint)));
+		drawn += count;
+	}
+
+	glBindVertexArray(0);
+	return drawn / 3;
+}
+
+void ChunkMesh::destroy() {
+	if (!VAO) return;
+
+	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &EBO);
+	VAO = 0;
+	VBO = 0;
+	EBO = 0;
+	bytes = 0;
+}
+
+bool ChunkMesh::isUploaded() {
+	return VAO != 0;
+}
+
+size_t ChunkMesh::getMemoryUsage() {
+	return bytes;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "GL/glew.h"
+
+// Chunk vertices are packed into two words, which the chunk shader unpacks.
+// position: x, y and z of the block in the chunk (6 bits each), the corner of the block (3 bits),
+// the face direction (3 bits) and ambient occlusion (2 bits)
+// block: block light (4 bits), sky light (4 bits) and block id (8 bits)
+struct ChunkVertex {
+	std::uint32_t position;
+	std::uint32_t block;
+};
+
+// GPU buffers of a chunk's faces. Faces are grouped per direction (left, right, down, up, front, back),
+// so whole directions can be skipped while drawing.
+class ChunkMesh {
+public:
+	ChunkMesh();
+	~ChunkMesh();
+	ChunkMesh(const ChunkMesh&) = delete;
+	ChunkMesh& operator=(const ChunkMesh&) = delete;
+
+	void upload(const std::vector<ChunkVertex>& pVertices, const std::vector<GLuint>& pIndices, const int pSectionCounts[6]);
+	int draw(const bool pSections[6]);
+	void destroy();
+
+	bool isUploaded();
+	size_t getMemoryUsage();
+
+private:
+	GLuint VAO;
+	GLuint VBO;
+	GLuint EBO;
+
+	int sectionStarts[6];
+	int sectionCounts[6];
+	size_t bytes;
+};
\ No newline at end of file
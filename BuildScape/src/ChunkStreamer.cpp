@@ -0,0 +1,214 @@
+#include "ChunkStreamer.h"
+
+#include <algorithm>
+
+ChunkStreamer::ChunkStreamer(World* pWorld, Camera* pCamera, int pRadius, size_t pMemoryBudget)
+	: world(pWorld), camera(pCamera), enabled(false), radius(pRadius), memoryBudget(pMemoryBudget), loadsPerUpdate(64),
+	coldDelay(10.0f), lastColdCheck(0.0f), misses(0), centre(glm::ivec3(0, 0, 0)), pending(false), evicted(0)
+{
+
+}
+
+ChunkStreamer::~ChunkStreamer() {
+
+}
+
+bool ChunkStreamer::update() {
+	if (!enabled) return false;
+
+	// Only look for missing chunks when the camera entered a new chunk or loading isn't done yet
+	glm::ivec3 newCentre = world->getChunkCoordinatesAt(camera->getPosition());
+	if (newCentre != centre) {
+		glm::ivec3 direction = glm::clamp(newCentre - centre, glm::ivec3(-1), glm::ivec3(1));
+		centre = newCentre;
+		pending = true;
+
+		prefetch(direction);
+	}
+
+	int loaded = pending ? loadMissing() : 0;
+
+	// Chunks that haven't been in view for a while are compressed before they're evicted.
+	// The octree backend keeps the unloaded chunks, its shared subtrees are merged again every now and then.
+	float time = (float)glfwGetTime();
+	if (time - lastColdCheck > 1.0f) {
+		lastColdCheck = time;
+		compressCold(time);
+		world->compactOctree();
+	}
+
+	int unloaded = evict();
+	return loaded > 0 || unloaded > 0;
+}
+
+int ChunkStreamer::loadMissing() {
+	// Collect every chunk in the radius that isn't resident yet
+	std::vector<glm::ivec3> missing;
+	for (int cZ = centre.z - radius; cZ <= centre.z + radius; cZ++) {
+		for (int cY = centre.y - radius; cY <= centre.y + radius; cY++) {
+			for (int cX = centre.x - radius; cX <= centre.x + radius; cX++) {
+				if (!world->getChunk(cX, cY, cZ)) missing.push_back(glm::ivec3(cX, cY, cZ));
+			}
+		}
+	}
+
+	// Load the closest chunks first, spreading the rest over the next updates
+	glm::ivec3 from = centre;
+	std::sort(missing.begin(), missing.end(), [from](const glm::ivec3& a, const glm::ivec3& b) {
+		glm::ivec3 da = a - from;
+		glm::ivec3 db = b - from;
+		return da.x * da.x + da.y * da.y + da.z * da.z < db.x * db.x + db.y * db.y + db.z * db.z;
+	});
+
+	int count = std::min((int)missing.size(), loadsPerUpdate);
+	for (int i = 0; i < count; i++) {
+		world->loadChunk(missing[i].x, missing[i].y, missing[i].z);
+	}
+	misses += count;
+
+	pending = count < (int)missing.size();
+	return count;
+}
+
+int ChunkStreamer::evict() {
+	// Blocks in RAM and meshes in VRAM share the budget
+	size_t bytes = getResidentBytes();
+	if (bytes <= memoryBudget) return 0;
+
+	// Chunks outside the radius are candidates, least recently visible first
+	std::vector<Chunk*> candidates;
+	for (auto& pair : world->getChunks()) {
+		if (!isInRadius(pair.second->getCoordinates())) candidates.push_back(pair.second.get());
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](Chunk* a, Chunk* b) {
+		return a->getLastVisible() < b->getLastVisible();
+	});
+
+	// Evict until we're back under the budget
+	int count = 0;
+	for (Chunk* chunk : candidates) {
+		if (bytes <= memoryBudget) break;
+
+		bytes -= chunk->getMemoryUsage() + chunk->getMesh().getMemoryUsage();
+		glm::ivec3 coordinates = chunk->getCoordinates();
+		world->unloadChunk(coordinates.x, coordinates.y, coordinates.z);
+		count++;
+	}
+
+	// Make the chunks that were written while unloading visible on disk
+	if (count > 0) world->commitRegions();
+
+	evicted += count;
+	return count;
+}
+
+void ChunkStreamer::prefetch(glm::ivec3 pDirection) {
+	// Have the OS read the chunks just past the radius in the direction the camera is moving
+	// Chunks in regions that aren't open yet are skipped, so prefetching never closes a region that's in use
+	for (int step = 1; step <= 2; step++) {
+		glm::ivec3 ahead = centre + pDirection * (radius + step);
+
+		for (int a = -radius; a <= radius; a++) {
+			for (int b = -radius; b <= radius; b++) {
+				if (pDirection.x != 0) world->prefetchChunk(ahead.x, centre.y + a, centre.z + b);
+				if (pDirection.y != 0) world->prefetchChunk(centre.x + a, ahead.y, centre.z + b);
+				if (pDirection.z != 0) world->prefetchChunk(centre.x + a, centre.y + b, ahead.z);
+			}
+		}
+	}
+}
+
+void ChunkStreamer::compressCold(float pTime) {
+	for (auto& pair : world->getChunks()) {
+		Chunk& chunk = *pair.second;
+		if (chunk.isEmpty() || chunk.isCompressed()) continue;
+
+		if (pTime - chunk.getLastVisible() <= coldDelay) continue;
+
+		// Only the blocks are kept, the mesh is rebuilt once the chunk is in view again
+		chunk.compress();
+		chunk.getMesh().destroy();
+		chunk.setMeshDirty(true);
+	}
+}
+
+bool ChunkStreamer::isInRadius(glm::ivec3 pCoordinates) {
+	glm::ivec3 delta = glm::abs(pCoordinates - centre);
+	return delta.x <= radius && delta.y <= radius && delta.z <= radius;
+}
+
+void ChunkStreamer::setEnabled(bool pEnabled) {
+	enabled = pEnabled;
+	pending = enabled;
+	centre = world->getChunkCoordinatesAt(camera->getPosition());
+}
+
+bool ChunkStreamer::isEnabled() {
+	return enabled;
+}
+
+void ChunkStreamer::setRadius(int pRadius) {
+	radius = pRadius;
+	pending = true;
+}
+
+int ChunkStreamer::getRadius() {
+	return radius;
+}
+
+void ChunkStreamer::setMemoryBudget(size_t pBytes) {
+	memoryBudget = pBytes;
+}
+
+size_t ChunkStreamer::getMemoryBudget() {
+	return memoryBudget;
+}
+
+void ChunkStreamer::setLoadsPerUpdate(int pLoads) {
+	loadsPerUpdate = pLoads;
+}
+
+int ChunkStreamer::getResidentCount() {
+	return (int)world->getChunks().size();
+}
+
+size_t ChunkStreamer::getResidentBytes() {
+	// The octree backend holds the unloaded chunks, so it takes its part of the budget as well
+	return world->getMemoryUsage() + world->getMeshMemoryUsage() + world->getOctreeMemoryUsage();
+}
+
+int ChunkStreamer::getEvictedCount() {
+	return evicted;
+}
+
+void ChunkStreamer::setColdDelay(float pSeconds) {
+	coldDelay = pSeconds;
+}
+
+int ChunkStreamer::getColdCount() {
+	int count = 0;
+	for (auto& pair : world->getChunks()) {
+		if (pair.second->isCompressed()) count++;
+	}
+	return count;
+}
+
+size_t ChunkStreamer::getColdBytes() {
+	size_t bytes = 0;
+	for (auto& pair : world->getChunks()) {
+		if (pair.second->isCompressed()) bytes += pair.second->getMemoryUsage();
+	}
+	return bytes;
+}
+
+float ChunkStreamer::getColdHitRate() {
+	// A hit is a chunk that came back from the compressed tier, a miss one that was read from disk or generated
+	int hits = world->getColdHitCount();
+	return hits + misses == 0 ? 0.0f : (float)hits / (hits + misses);
+}
+
+double ChunkStreamer::getAverageDecompressTime() {
+	int count = Chunk::getDecompressCount();
+	return count == 0 ? 0.0 : Chunk::getDecompressTime() / count;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+#include "World.h"
+#include "Camera.h"
+
+#include "glm/glm.hpp"
+
+class ChunkStreamer {
+public:
+	ChunkStreamer(World* pWorld, Camera* pCamera, int pRadius, size_t pMemoryBudget);
+	~ChunkStreamer();
+
+	bool update();
+
+	void setEnabled(bool pEnabled);
+	bool isEnabled();
+
+	void setRadius(int pRadius);
+	int getRadius();
+	void setMemoryBudget(size_t pBytes);
+	size_t getMemoryBudget();
+	void setLoadsPerUpdate(int pLoads);
+	void setColdDelay(float pSeconds);
+
+	int getColdCount();
+	size_t getColdBytes();
+	float getColdHitRate();
+	double getAverageDecompressTime();
+
+	int getResidentCount();
+	size_t getResidentBytes();
+	int getEvictedCount();
+
+private:
+	World* world;
+	Camera* camera;
+
+	bool enabled;
+	int radius;
+	size_t memoryBudget;
+	int loadsPerUpdate;
+	float coldDelay;
+	float lastColdCheck;
+	int misses;
+
+	glm::ivec3 centre;
+	bool pending;
+	int evicted;
+
+	bool isInRadius(glm::ivec3 pCoordinates);
+	int loadMissing();
+	void prefetch(glm::ivec3 pDirection);
+	int evict();
+	void compressCold(float pTime);
+};
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "Collision.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Distance that counts as touching, in voxels
+static const float skin = 0.001f;
+
+// Finds solid voxels in a range of voxels, going through it chunk by chunk and skipping chunks without blocks.
+// The function returns false to stop the search, forEachSolid then returns false as well.
+class VoxelQuery {
+public:
+	VoxelQuery(World& pWorld)
+		: world(pWorld), dimensions(World::getChunkDimensions())
+	{
+
+	}
+
+	template <typename Function>
+	bool forEachSolid(glm::ivec3 pMin, glm::ivec3 pMax, Function pFunction) {
+		glm::ivec3 minChunk = World::getVoxelChunkCoordinates(pMin);
+		glm::ivec3 maxChunk = World::getVoxelChunkCoordinates(pMax);
+
+		for (int cY = minChunk.y; cY <= maxChunk.y; cY++) {
+			for (int cZ = minChunk.z; cZ <= maxChunk.z; cZ++) {
+				for (int cX = minChunk.x; cX <= maxChunk.x; cX++) {
+					Chunk* chunk = world.getChunk(cX, cY, cZ);
+					if (!chunk || chunk->isEmpty()) continue;
+
+					// Only the part of the range inside this chunk
+					glm::ivec3 origin = glm::ivec3(cX, cY, cZ) * dimensions;
+					glm::ivec3 from = glm::max(pMin, origin) - origin;
+					glm::ivec3 to = glm::min(pMax, origin + dimensions - 1) - origin;
+
+					std::vector<std::uint32_t>& blocks = chunk->getBlocks();
+					for (int y = from.y; y <= to.y; y++) {
+						for (int z = from.z; z <= to.z; z++) {
+							for (int x = from.x; x <= to.x; x++) {
+								if (((blocks[Chunk::getIndex(x, y, z)] >> 12) & 0xFF) && !pFunction(origin + glm::ivec3(x, y, z))) return false;
+							}
+						}
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+private:
+	World& world;
+	glm::ivec3 dimensions;
+};
+
+// Moves the box along one axis as far as the voxels in the way allow, the box is in voxel units
+static float sweepAxis(VoxelQuery& pQuery, glm::vec3& pMin, glm::vec3& pMax, int pAxis, float pDelta) {
+	if (pDelta == 0.0f) return 0.0f;
+
+	// The voxels the box overlaps on the other axes
+	glm::ivec3 from(glm::floor(pMin));
+	glm::ivec3 to(glm::ceil(pMax) - 1.0f);
+
+	// And the ones it passes along the axis, the ones it's already in don't stop it
+	if (pDelta > 0.0f) {
+		from[pAxis] = (int)std::floor(pMax[pAxis] - skin);
+		to[pAxis] = (int)std::floor(pMax[pAxis] + pDelta);
+	} else {
+		from[pAxis] = (int)std::floor(pMin[pAxis] + pDelta);
+		to[pAxis] = (int)std::ceil(pMin[pAxis] + skin) - 1;
+	}
+
+	float delta = pDelta;
+	pQuery.forEachSolid(from, to, [&](glm::ivec3 pVoxel) {
+		float face = (float)pVoxel[pAxis];
+		if (pDelta > 0.0f) {
+			if (face >= pMax[pAxis] - skin) delta = std::min(delta, std::max(face - pMax[pAxis], 0.0f));
+		} else {
+			if (face + 1.0f <= pMin[pAxis] + skin) delta = std::max(delta, std::min(face + 1.0f - pMin[pAxis], 0.0f));
+		}
+		return true;
+	});
+
+	pMin[pAxis] += delta;
+	pMax[pAxis] += delta;
+	return delta;
+}
+
+static CollisionResult moveBox(World& pWorld, VoxelQuery& pQuery, AABB& pBox, glm::vec3 pDelta) {
+	// Voxel v covers [v, v + 1) in voxel units
+	float voxelSize = pWorld.getVoxelSize();
+	glm::vec3 min = pBox.min / voxelSize + 0.5f;
+	glm::vec3 max = pBox.max / voxelSize + 0.5f;
+	glm::vec3 delta = pDelta / voxelSize;
+
+	// Vertical movement first, so walking into a step slides over the ground
+	CollisionResult result;
+	const int axes[3] = { 1, 0, 2 };
+	for (int axis : axes) {
+		float moved = sweepAxis(pQuery, min, max, axis, delta[axis]);
+		result.blocked[axis] = moved != delta[axis];
+		result.delta[axis] = moved * voxelSize;
+	}
+
+	pBox.min = (min - 0.5f) * voxelSize;
+	pBox.max = (max - 0.5f) * voxelSize;
+	result.grounded = Collision::isGrounded(pWorld, pBox);
+	return result;
+}
+
+CollisionResult Collision::move(World& pWorld, AABB& pBox, glm::vec3 pDelta) {
+	VoxelQuery query(pWorld);
+	return moveBox(pWorld, query, pBox, pDelta);
+}
+
+void Collision::moveBatch(World& pWorld, AABB* pBoxes, const glm::vec3* pDeltas, CollisionResult* pResults, int pCount) {
+	VoxelQuery query(pWorld);
+	for (int i = 0; i < pCount; i++) {
+		pResults[i] = moveBox(pWorld, query, pBoxes[i], pDeltas[i]);
+	}
+}
+
+bool Collision::isGrounded(World& pWorld, const AABB& pBox) {
+	// Any solid voxel right below the box
+	float voxelSize = pWorld.getVoxelSize();
+	glm::vec3 min = pBox.min / voxelSize + 0.5f;
+	glm::vec3 max = pBox.max / voxelSize + 0.5f;
+
+	glm::ivec3 from(glm::floor(min));
+	glm::ivec3 to(glm::ceil(max) - 1.0f);
+	from.y = (int)std::floor(min.y - skin * 2.0f);
+	to.y = from.y;
+
+	VoxelQuery query(pWorld);
+	return !query.forEachSolid(from, to, [&](glm::ivec3 pVoxel) {
+		return (float)pVoxel.y + 1.0f < min.y - skin * 2.0f;
+	});
+}
+
+bool Collision::overlaps(World& pWorld, const AABB& pBox) {
+	float voxelSize = pWorld.getVoxelSize();
+	glm::ivec3 from(glm::floor(pBox.min / voxelSize + 0.5f));
+	glm::ivec3 to(glm::ceil(pBox.max / voxelSize + 0.5f) - 1.0f);
+
+	// The first solid voxel is enough
+	VoxelQuery query(pWorld);
+	return !query.forEachSolid(from, to, [](glm::ivec3) {
+		return false;
+	});
+}
\ No newline at end of file
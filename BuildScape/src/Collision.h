@@ -0,0 +1,26 @@
+#pragma once
+
+#include "World.h"
+
+struct AABB {
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+struct CollisionResult {
+	glm::vec3 delta;
+	glm::bvec3 blocked;
+	bool grounded;
+};
+
+// Boxes moving through the voxel grid. A move is resolved one axis at a time against the voxels
+// the box sweeps over, so a box that hits a wall keeps sliding along it.
+class Collision {
+public:
+	Collision() = delete;
+
+	static CollisionResult move(World& pWorld, AABB& pBox, glm::vec3 pDelta);
+	static void moveBatch(World& pWorld, AABB* pBoxes, const glm::vec3* pDeltas, CollisionResult* pResults, int pCount);
+	static bool isGrounded(World& pWorld, const AABB& pBox);
+	static bool overlaps(World& pWorld, const AABB& pBox);
+};
\ No newline at end of file
@@ -0,0 +1,375 @@
+#include "CpuRenderer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#include "stb_image/stb_image_write.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPU_RENDERER_SSE
+#include <emmintrin.h>
+#endif
+
+CpuRenderer::CpuRenderer(World* pWorld)
+	: world(pWorld), maxDistance(100.0f), lastRenderTime(0.0), lastRayCount(0), imageWidth(0), imageHeight(0), imagePixels(nullptr),
+	nextTile(0), workGeneration(0), busyWorkers(0), stopping(false)
+{
+	threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+CpuRenderer::~CpuRenderer() {
+	stopWorkers();
+}
+
+void CpuRenderer::render(const glm::mat4& pView, const glm::mat4& pProjection, int pWidth, int pHeight, std::vector<std::uint8_t>& pPixels) {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Every chunk's blocks are gathered before the workers start, so they don't have to go through the world
+	// Rays only have to be traced through the box around those chunks
+	chunkBlocks.clear();
+	glm::ivec3 minChunk(INT_MAX);
+	glm::ivec3 maxChunk(INT_MIN);
+	for (auto& pair : world->getChunks()) {
+		Chunk& chunk = *pair.second;
+		if (chunk.isEmpty()) continue;
+
+		chunkBlocks[pair.first] = chunk.getBlocks().data();
+		minChunk = glm::min(minChunk, chunk.getCoordinates());
+		maxChunk = glm::max(maxChunk, chunk.getCoordinates());
+	}
+	boundsMin = chunkBlocks.empty() ? glm::vec3(1.0f) : glm::vec3(minChunk * World::getChunkDimensions());
+	boundsMax = chunkBlocks.empty() ? glm::vec3(0.0f) : glm::vec3((maxChunk + 1) * World::getChunkDimensions());
+
+	pPixels.assign((size_t)pWidth * pHeight * 3, 0);
+	imageWidth = pWidth;
+	imageHeight = pHeight;
+	imageInverse = glm::inverse(pProjection * pView);
+	imageOrigin = glm::vec3(glm::inverse(pView)[3]);
+	imagePixels = pPixels.data();
+	nextTile = 0;
+
+	// This thread renders tiles as well, the workers only have to cover the other threads
+	if ((int)workers.size() != threadCount - 1) startWorkers(threadCount - 1);
+	{
+		std::lock_guard<std::mutex> lock(workMutex);
+		workGeneration++;
+		busyWorkers = (int)workers.size();
+	}
+	workStart.notify_all();
+	renderTiles();
+	{
+		std::unique_lock<std::mutex> lock(workMutex);
+		workDone.wait(lock, [this]() { return busyWorkers == 0; });
+	}
+
+	chunkBlocks.clear();
+	imagePixels = nullptr;
+	lastRenderTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	lastRayCount = (size_t)pWidth * pHeight;
+}
+
+bool CpuRenderer::renderToFile(const glm::mat4& pView, const glm::mat4& pProjection, int pWidth, int pHeight, const std::string& pPath) {
+	std::vector<std::uint8_t> pixels;
+	render(pView, pProjection, pWidth, pHeight, pixels);
+	if (!stbi_write_png(pPath.c_str(), pWidth, pHeight, 3, pixels.data(), pWidth * 3)) {
+		std::cout << "[ERROR] Could not write " << pPath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void CpuRenderer::startWorkers(int pCount) {
+	stopWorkers();
+	for (int i = 0; i < pCount; i++) {
+		workers.emplace_back(&CpuRenderer::work, this, workGeneration);
+	}
+}
+
+void CpuRenderer::stopWorkers() {
+	{
+		std::lock_guard<std::mutex> lock(workMutex);
+		stopping = true;
+	}
+	workStart.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	stopping = false;
+}
+
+void CpuRenderer::work(int pGeneration) {
+	// Every render raises the generation, which wakes the workers once
+	int generation = pGeneration;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(workMutex);
+			workStart.wait(lock, [this, generation]() { return stopping || workGeneration != generation; });
+			if (stopping) return;
+			generation = workGeneration;
+		}
+
+		renderTiles();
+
+		std::lock_guard<std::mutex> lock(workMutex);
+		if (--busyWorkers == 0) workDone.notify_one();
+	}
+}
+
+void CpuRenderer::renderTiles() {
+	int tilesX = (imageWidth + TILE_SIZE - 1) / TILE_SIZE;
+	int tilesY = (imageHeight + TILE_SIZE - 1) / TILE_SIZE;
+
+	for (int tile = nextTile++; tile < tilesX * tilesY; tile = nextTile++) {
+		int tileX = (tile % tilesX) * TILE_SIZE;
+		int tileY = (tile / tilesX) * TILE_SIZE;
+
+		for (int y = tileY; y < std::min(tileY + TILE_SIZE, imageHeight); y += 2) {
+			for (int x = tileX; x < std::min(tileX + TILE_SIZE, imageWidth); x += 2) {
+				// A packet of 2x2 pixels, the ones outside the image are traced but not stored
+				glm::vec3 directions[4];
+				bool active[4];
+				for (int i = 0; i < 4; i++) {
+					int pixelX = x + (i & 1);
+					int pixelY = y + (i >> 1);
+					active[i] = pixelX < imageWidth && pixelY < imageHeight;
+
+					// The first row of the image is the top of the screen
+					float ndcX = (pixelX + 0.5f) / imageWidth * 2.0f - 1.0f;
+					float ndcY = 1.0f - (pixelY + 0.5f) / imageHeight * 2.0f;
+					glm::vec4 nearPoint = imageInverse * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+					glm::vec4 farPoint = imageInverse * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+					directions[i] = glm::normalize(glm::vec3(farPoint) / farPoint.w - glm::vec3(nearPoint) / nearPoint.w);
+				}
+
+				glm::vec3 colours[4];
+				tracePacket(imageOrigin, directions, active, colours);
+
+				for (int i = 0; i < 4; i++) {
+					if (!active[i]) continue;
+
+					std::uint8_t* pixel = &imagePixels[((size_t)(y + (i >> 1)) * imageWidth + x + (i & 1)) * 3];
+					pixel[0] = (std::uint8_t)(colours[i].r * 255.0f + 0.5f);
+					pixel[1] = (std::uint8_t)(colours[i].g * 255.0f + 0.5f);
+					pixel[2] = (std::uint8_t)(colours[i].b * 255.0f + 0.5f);
+				}
+			}
+		}
+	}
+}
+
+void CpuRenderer::tracePacket(glm::vec3 pOrigin, const glm::vec3 pDirections[4], const bool pActive[4], glm::vec3 pColours[4]) {
+	// Lanes are stored per axis, so the stepping works on all four rays at once.
+	// Work in voxel units, where voxel v covers [v, v + 1).
+	float voxelSize = world->getVoxelSize();
+	float maxT = maxDistance / voxelSize;
+	glm::vec3 origin = pOrigin / voxelSize + 0.5f;
+	glm::ivec3 dimensions = World::getChunkDimensions();
+
+	alignas(16) float direction[3][4];
+	alignas(16) float tMax[3][4];
+	alignas(16) float tDelta[3][4];
+	alignas(16) std::int32_t voxel[3][4];
+	alignas(16) std::int32_t step[3][4];
+	alignas(16) float t[4];
+	alignas(16) std::int32_t stepping[4];
+
+	bool active[4];
+	float laneMaxT[4];
+	float hitT[4];
+	glm::ivec3 laneChunk[4];
+	const std::uint32_t* laneBlocks[4];
+
+	for (int i = 0; i < 4; i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			float d = pDirections[i][axis];
+			direction[axis][i] = d;
+			voxel[axis][i] = (int)std::floor(origin[axis]);
+			step[axis][i] = d > 0.0f ? 1 : (d < 0.0f ? -1 : 0);
+			tDelta[axis][i] = d != 0.0f ? 1.0f / std::fabs(d) : FLT_MAX;
+			tMax[axis][i] = d != 0.0f ? ((float)(voxel[axis][i] + (d > 0.0f ? 1 : 0)) - origin[axis]) / d : FLT_MAX;
+		}
+
+		// Rays stop where they leave the box around the chunks with blocks
+		float enter = 0.0f;
+		laneMaxT[i] = maxT;
+		for (int axis = 0; axis < 3; axis++) {
+			float d = pDirections[i][axis];
+			if (d == 0.0f) {
+				if (origin[axis] < boundsMin[axis] || origin[axis] > boundsMax[axis]) laneMaxT[i] = -1.0f;
+				continue;
+			}
+
+			float t0 = (boundsMin[axis] - origin[axis]) / d;
+			float t1 = (boundsMax[axis] - origin[axis]) / d;
+			enter = std::max(enter, std::min(t0, t1));
+			laneMaxT[i] = std::min(laneMaxT[i], std::max(t0, t1));
+		}
+
+		// The first voxel is checked before stepping
+		t[i] = 0.0f;
+		stepping[i] = 0;
+		active[i] = pActive[i] && enter <= laneMaxT[i];
+		hitT[i] = -1.0f;
+		laneChunk[i] = glm::ivec3(INT_MAX);
+		laneBlocks[i] = nullptr;
+	}
+
+	while (active[0] || active[1] || active[2] || active[3]) {
+		// Step every lane that needs to along the axis with the nearest boundary
+#ifdef CPU_RENDERER_SSE
+		__m128 stepMask = _mm_castsi128_ps(_mm_load_si128((const __m128i*)stepping));
+		__m128 tx = _mm_load_ps(tMax[0]);
+		__m128 ty = _mm_load_ps(tMax[1]);
+		__m128 tz = _mm_load_ps(tMax[2]);
+
+		__m128 maskX = _mm_and_ps(_mm_cmple_ps(tx, ty), _mm_cmple_ps(tx, tz));
+		__m128 maskY = _mm_andnot_ps(maskX, _mm_cmple_ps(ty, tz));
+		__m128 maskZ = _mm_andnot_ps(_mm_or_ps(maskX, maskY), stepMask);
+		maskX = _mm_and_ps(maskX, stepMask);
+		maskY = _mm_and_ps(maskY, stepMask);
+
+		__m128 tNew = _mm_or_ps(_mm_or_ps(_mm_and_ps(maskX, tx), _mm_and_ps(maskY, ty)), _mm_and_ps(maskZ, tz));
+		_mm_store_ps(t, _mm_or_ps(tNew, _mm_andnot_ps(stepMask, _mm_load_ps(t))));
+
+		_mm_store_ps(tMax[0], _mm_add_ps(tx, _mm_and_ps(maskX, _mm_load_ps(tDelta[0]))));
+		_mm_store_ps(tMax[1], _mm_add_ps(ty, _mm_and_ps(maskY, _mm_load_ps(tDelta[1]))));
+		_mm_store_ps(tMax[2], _mm_add_ps(tz, _mm_and_ps(maskZ, _mm_load_ps(tDelta[2]))));
+
+		__m128 masks[3] = { maskX, maskY, maskZ };
+		for (int axis = 0; axis < 3; axis++) {
+			__m128i v = _mm_load_si128((const __m128i*)voxel[axis]);
+			__m128i s = _mm_and_si128(_mm_castps_si128(masks[axis]), _mm_load_si128((const __m128i*)step[axis]));
+			_mm_store_si128((__m128i*)voxel[axis], _mm_add_epi32(v, s));
+		}
+#else
+		for (int i = 0; i < 4; i++) {
+			if (!stepping[i]) continue;
+
+			int axis = tMax[0][i] <= tMax[1][i] && tMax[0][i] <= tMax[2][i] ? 0 : (tMax[1][i] <= tMax[2][i] ? 1 : 2);
+			t[i] = tMax[axis][i];
+			tMax[axis][i] += tDelta[axis][i];
+			voxel[axis][i] += step[axis][i];
+		}
+#endif
+
+		// Look up the blocks one lane at a time
+		for (int i = 0; i < 4; i++) {
+			stepping[i] = 0;
+			if (!active[i]) continue;
+			if (t[i] > laneMaxT[i]) {
+				active[i] = false;
+				continue;
+			}
+
+			glm::ivec3 position(voxel[0][i], voxel[1][i], voxel[2][i]);
+			glm::ivec3 coordinates = World::getVoxelChunkCoordinates(position);
+			if (coordinates != laneChunk[i]) {
+				laneChunk[i] = coordinates;
+				laneBlocks[i] = getChunkBlocks(coordinates);
+			}
+
+			glm::ivec3 chunkMin = coordinates * dimensions;
+			if (laneBlocks[i]) {
+				glm::ivec3 local = position - chunkMin;
+				if ((laneBlocks[i][Chunk::getIndex(local.x, local.y, local.z)] >> 12) & 0xFF) {
+					hitT[i] = t[i];
+					active[i] = false;
+				} else {
+					stepping[i] = -1;
+				}
+				continue;
+			}
+
+			// Jump to where the ray leaves a chunk without blocks, the voxel there is checked next
+			glm::ivec3 chunkMax = chunkMin + dimensions;
+			float exit = FLT_MAX;
+			int exitAxis = 0;
+			for (int axis = 0; axis < 3; axis++) {
+				if (step[axis][i] == 0) continue;
+
+				float tExit = ((float)(step[axis][i] > 0 ? chunkMax[axis] : chunkMin[axis]) - origin[axis]) / direction[axis][i];
+				if (tExit < exit) {
+					exit = tExit;
+					exitAxis = axis;
+				}
+			}
+
+			t[i] = exit;
+			for (int axis = 0; axis < 3; axis++) {
+				if (axis == exitAxis) voxel[axis][i] = step[axis][i] > 0 ? chunkMax[axis] : chunkMin[axis] - 1;
+				else voxel[axis][i] = glm::clamp((int)std::floor(origin[axis] + direction[axis][i] * exit), chunkMin[axis], chunkMax[axis] - 1);
+
+				if (step[axis][i] != 0) tMax[axis][i] = ((float)(voxel[axis][i] + (step[axis][i] > 0 ? 1 : 0)) - origin[axis]) / direction[axis][i];
+			}
+		}
+	}
+
+	// Same colours as the shader, which interpolates the corners of the voxel over its faces
+	for (int i = 0; i < 4; i++) {
+		if (hitT[i] < 0.0f) {
+			pColours[i] = glm::vec3(0.0f);
+			continue;
+		}
+
+		// The face the ray came in through shows the light in front of it
+		glm::ivec3 hitVoxel(voxel[0][i], voxel[1][i], voxel[2][i]);
+		int entryAxis = 0;
+		float entry = -FLT_MAX;
+		for (int axis = 0; axis < 3; axis++) {
+			if (step[axis][i] == 0) continue;
+
+			float tEntry = ((float)(hitVoxel[axis] + (step[axis][i] > 0 ? 0 : 1)) - origin[axis]) / direction[axis][i];
+			if (tEntry > entry) {
+				entry = tEntry;
+				entryAxis = axis;
+			}
+		}
+		glm::ivec3 front = hitVoxel;
+		front[entryAxis] -= step[entryAxis][i];
+
+		// Occlusion of the face's corners is blended over it, like the shader does
+		glm::vec3 fraction = glm::clamp(origin + pDirections[i] * hitT[i] - glm::vec3(hitVoxel), 0.0f, 1.0f);
+		int dir = entryAxis * 2 + (step[entryAxis][i] < 0 ? 1 : 0);
+		int axisA = (entryAxis + 1) % 3;
+		int axisB = (entryAxis + 2) % 3;
+		float occlusion = 0.0f;
+		for (int c = 0; c < 4; c++) {
+			int corner = ((c & 1) << axisA) | ((c >> 1) << axisB);
+			float weight = ((c & 1) ? fraction[axisA] : 1.0f - fraction[axisA]) * ((c & 2) ? fraction[axisB] : 1.0f - fraction[axisB]);
+			occlusion += weight * world->getCornerOcclusion(hitVoxel, dir, corner);
+		}
+
+		pColours[i] = fraction * LightEngine::getBrightness(world->getLight(front)) * (0.4f + 0.2f * occlusion);
+	}
+}
+
+const std::uint32_t* CpuRenderer::getChunkBlocks(glm::ivec3 pCoordinates) {
+	auto it = chunkBlocks.find(World::getChunkKey(pCoordinates.x, pCoordinates.y, pCoordinates.z));
+	return it == chunkBlocks.end() ? nullptr : it->second;
+}
+
+void CpuRenderer::setThreadCount(int pThreads) {
+	threadCount = std::max(1, pThreads);
+}
+
+int CpuRenderer::getThreadCount() {
+	return threadCount;
+}
+
+void CpuRenderer::setMaxDistance(float pDistance) {
+	maxDistance = pDistance;
+}
+
+double CpuRenderer::getLastRenderTime() {
+	return lastRenderTime;
+}
+
+double CpuRenderer::getRaysPerSecond() {
+	return lastRenderTime > 0.0 ? lastRayCount / lastRenderTime : 0.0;
+}
\ No newline at end of file
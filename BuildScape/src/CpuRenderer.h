@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "World.h"
+
+// Renders the world without a GPU by marching rays through the voxel grid.
+// The image is split into tiles for worker threads and rays are traced in packets of 2x2 pixels.
+class CpuRenderer {
+public:
+	CpuRenderer(World* pWorld);
+	~CpuRenderer();
+
+	void render(const glm::mat4& pView, const glm::mat4& pProjection, int pWidth, int pHeight, std::vector<std::uint8_t>& pPixels);
+	bool renderToFile(const glm::mat4& pView, const glm::mat4& pProjection, int pWidth, int pHeight, const std::string& pPath);
+
+	void setThreadCount(int pThreads);
+	int getThreadCount();
+	void setMaxDistance(float pDistance);
+	double getLastRenderTime();
+	double getRaysPerSecond();
+
+	static const int TILE_SIZE = 16;
+
+private:
+	World* world;
+	int threadCount;
+	float maxDistance;
+	double lastRenderTime;
+	size_t lastRayCount;
+
+	// Blocks of every chunk with blocks, looked up by the workers without touching the world
+	std::unordered_map<std::int64_t, const std::uint32_t*> chunkBlocks;
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+
+	// The image being rendered, set before the workers are woken
+	int imageWidth;
+	int imageHeight;
+	glm::mat4 imageInverse;
+	glm::vec3 imageOrigin;
+	std::uint8_t* imagePixels;
+
+	// Workers are started once and woken for every render, then take tiles until none are left
+	std::vector<std::thread> workers;
+	std::mutex workMutex;
+	std::condition_variable workStart;
+	std::condition_variable workDone;
+	std::atomic<int> nextTile;
+	int workGeneration;
+	int busyWorkers;
+	bool stopping;
+
+	void startWorkers(int pCount);
+	void stopWorkers();
+	void work(int pGeneration);
+	void renderTiles();
+	void tracePacket(glm::vec3 pOrigin, const glm::vec3 pDirections[4], const bool pActive[4], glm::vec3 pColours[4]);
+	const std::uint32_t* getChunkBlocks(glm::ivec3 pCoordinates);
+};
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "Debug.h"
 
+#include "Profiler.h"
+
 Debug::Debug(const char* pDebugName, int pWidth, int pHeight)
 	: debugName(pDebugName), debugSize(glm::vec2(pWidth, pHeight)), collapsed(false)
 {
@@ -32,6 +34,8 @@ void Debug::destroy() {
 }
 
 void Debug::draw() {
+	PROFILE_SCOPE("Debug::draw");
+
 	// Start a new frame
 	ImGui_ImplGlfwGL3_NewFrame();
 
@@ -58,6 +62,14 @@ void Debug::draw() {
 	ImGui::Text("");
 	ImGui::Text("%.3f ms/frame", 1000.0f / ImGui::GetIO().Framerate);
 	ImGui::Text("%.1f FPS", ImGui::GetIO().Framerate);
+	if (!collapsed) {
+		for (const auto& stat : stats) {
+			ImGui::Text("%s", stat().c_str());
+		}
+		for (const auto& panel : panels) {
+			panel();
+		}
+	}
 	ImGui::End();
 
 	ImGui::PopStyleVar();
@@ -81,4 +93,12 @@ void Debug::addLine(const char* pLine) {
 
 void Debug::addButton(const char* pLine, std::function<void()> pFunction) {
 	buttons[pLine] = pFunction;
+}
+
+void Debug::addStat(std::function<std::string()> pFunction) {
+	stats.push_back(pFunction);
+}
+
+void Debug::addPanel(std::function<void()> pFunction) {
+	panels.push_back(pFunction);
 }
\ No newline at end of file
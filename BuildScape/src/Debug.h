@@ -6,6 +6,7 @@
 #include "imgui/imgui_impl_glfw_gl3.h"
 #include <map>
 #include <functional>
+#include <string>
 
 class Debug {
 public:
@@ -20,11 +21,15 @@ public:
 	void setCollapsed(bool pCollapsed);
 	void addLine(const char* pLine);
 	void addButton(const char* pLine, std::function<void()> pFunction);
+	void addStat(std::function<std::string()> pFunction);
+	void addPanel(std::function<void()> pFunction);
 
 private:
 	const char* debugName;
 	glm::vec2 debugSize;
 	std::vector<const char*> lines;
 	std::map<const char*, std::function<void()>> buttons;
+	std::vector<std::function<std::string()>> stats;
+	std::vector<std::function<void()>> panels;
 	bool collapsed;
 };
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "EditBatch.h"
+#include "World.h"
+
+EditBatch::EditBatch()
+	: editCount(0)
+{
+
+}
+
+EditBatch::~EditBatch() {
+
+}
+
+void EditBatch::setBlock(glm::ivec3 pVoxel, std::uint8_t pId) {
+	glm::ivec3 coordinates = World::getVoxelChunkCoordinates(pVoxel);
+	glm::ivec3 local = pVoxel - coordinates * World::getChunkDimensions();
+
+	// Edits are applied in order, so a later edit of the same voxel wins
+	getChunkEdits(coordinates).edits.push_back({ Chunk::getIndex(local.x, local.y, local.z), pId });
+	editCount++;
+}
+
+void EditBatch::fill(glm::ivec3 pMin, glm::ivec3 pMax, std::uint8_t pId) {
+	if (glm::any(glm::greaterThanEqual(pMin, pMax))) return;
+
+	// Fill chunk by chunk, so every chunk's edits are added in one go
+	glm::ivec3 dimensions = World::getChunkDimensions();
+	glm::ivec3 minChunk = World::getVoxelChunkCoordinates(pMin);
+	glm::ivec3 maxChunk = World::getVoxelChunkCoordinates(pMax - 1);
+
+	for (int cY = minChunk.y; cY <= maxChunk.y; cY++) {
+		for (int cZ = minChunk.z; cZ <= maxChunk.z; cZ++) {
+			for (int cX = minChunk.x; cX <= maxChunk.x; cX++) {
+				glm::ivec3 origin = glm::ivec3(cX, cY, cZ) * dimensions;
+				glm::ivec3 from = glm::max(pMin, origin) - origin;
+				glm::ivec3 to = glm::min(pMax, origin + dimensions) - origin;
+
+				std::vector<Edit>& edits = getChunkEdits(glm::ivec3(cX, cY, cZ)).edits;
+				for (int y = from.y; y < to.y; y++) {
+					for (int z = from.z; z < to.z; z++) {
+						for (int x = from.x; x < to.x; x++) {
+							edits.push_back({ Chunk::getIndex(x, y, z), pId });
+						}
+					}
+				}
+				editCount += (size_t)(to.x - from.x) * (to.y - from.y) * (to.z - from.z);
+			}
+		}
+	}
+}
+
+void EditBatch::addRun(glm::ivec3 pCoordinates, int pStart, int pLength, std::uint8_t pId) {
+	// Consecutive indices of a single chunk
+	std::vector<Edit>& edits = getChunkEdits(pCoordinates).edits;
+	for (int index = pStart; index < pStart + pLength; index++) {
+		edits.push_back({ index, pId });
+	}
+	editCount += pLength;
+}
+
+void EditBatch::clear() {
+	chunks.clear();
+	editCount = 0;
+}
+
+std::unordered_map<std::int64_t, EditBatch::ChunkEdits>& EditBatch::getChunks() {
+	return chunks;
+}
+
+size_t EditBatch::getEditCount() {
+	return editCount;
+}
+
+bool EditBatch::isEmpty() {
+	return editCount == 0;
+}
+
+EditBatch::ChunkEdits& EditBatch::getChunkEdits(glm::ivec3 pCoordinates) {
+	ChunkEdits& chunkEdits = chunks[World::getChunkKey(pCoordinates.x, pCoordinates.y, pCoordinates.z)];
+	chunkEdits.coordinates = pCoordinates;
+	return chunkEdits;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+
+// Block edits collected per chunk, so World::apply can handle each chunk once
+class EditBatch {
+public:
+	struct Edit {
+		int index;
+		std::uint8_t id;
+	};
+
+	struct ChunkEdits {
+		glm::ivec3 coordinates;
+		std::vector<Edit> edits;
+	};
+
+	EditBatch();
+	~EditBatch();
+
+	void setBlock(glm::ivec3 pVoxel, std::uint8_t pId);
+	void fill(glm::ivec3 pMin, glm::ivec3 pMax, std::uint8_t pId);
+	void addRun(glm::ivec3 pCoordinates, int pStart, int pLength, std::uint8_t pId);
+	void clear();
+
+	std::unordered_map<std::int64_t, ChunkEdits>& getChunks();
+	size_t getEditCount();
+	bool isEmpty();
+
+private:
+	std::unordered_map<std::int64_t, ChunkEdits> chunks;
+	size_t editCount;
+
+	ChunkEdits& getChunkEdits(glm::ivec3 pCoordinates);
+};
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "EditJournal.h"
+#include "World.h"
+
+#include <algorithm>
+
+// Chunks the streamer evicted are loaded again, so a transaction always covers all of its chunks
+static Chunk* loadChunk(World& pWorld, glm::ivec3 pCoordinates) {
+	Chunk* chunk = pWorld.getChunk(pCoordinates.x, pCoordinates.y, pCoordinates.z);
+	return chunk ? chunk : pWorld.loadChunk(pCoordinates.x, pCoordinates.y, pCoordinates.z);
+}
+
+EditJournal::EditJournal(size_t pMemoryBudget)
+	: memoryBudget(pMemoryBudget), bytes(0)
+{
+
+}
+
+EditJournal::~EditJournal() {
+
+}
+
+int EditJournal::apply(World& pWorld, EditBatch& pBatch) {
+	Transaction transaction;
+	transaction.bytes = sizeof(Transaction);
+
+	for (auto& pair : pBatch.getChunks()) {
+		EditBatch::ChunkEdits& chunkEdits = pair.second;
+		Chunk* chunk = loadChunk(pWorld, chunkEdits.coordinates);
+
+		// Sort the edits by index, the last edit of a voxel is the one that counts
+		std::vector<EditBatch::Edit> edits = chunkEdits.edits;
+		std::stable_sort(edits.begin(), edits.end(), [](const EditBatch::Edit& a, const EditBatch::Edit& b) {
+			return a.index < b.index;
+		});
+
+		// Compare with the blocks as they are now and merge the changes into runs
+		ChunkDelta delta;
+		delta.coordinates = chunkEdits.coordinates;
+		for (size_t i = 0; i < edits.size(); i++) {
+			if (i + 1 < edits.size() && edits[i + 1].index == edits[i].index) continue;
+
+			std::uint8_t oldId = chunk->isEmpty() ? 0 : (chunk->getBlocks()[edits[i].index] >> 12) & 0xFF;
+			std::uint8_t newId = edits[i].id;
+			if (oldId == newId) continue;
+
+			if (!delta.runs.empty()) {
+				Run& last = delta.runs.back();
+				if (last.start + last.length == (std::uint32_t)edits[i].index && last.oldId == oldId && last.newId == newId) {
+					last.length++;
+					continue;
+				}
+			}
+			delta.runs.push_back({ (std::uint32_t)edits[i].index, 1, oldId, newId });
+		}
+
+		if (delta.runs.empty()) continue;
+		delta.runs.shrink_to_fit();
+		transaction.bytes += sizeof(ChunkDelta) + delta.runs.size() * sizeof(Run);
+		transaction.chunks.push_back(std::move(delta));
+	}
+
+	int changed = pWorld.apply(pBatch);
+	if (transaction.chunks.empty()) return changed;
+
+	// A new edit makes the undone transactions unreachable
+	for (Transaction& undone : redoStack) {
+		bytes -= undone.bytes;
+	}
+	redoStack.clear();
+
+	bytes += transaction.bytes;
+	undoStack.push_back(std::move(transaction));
+	trim();
+	return changed;
+}
+
+bool EditJournal::undo(World& pWorld) {
+	if (undoStack.empty()) return false;
+
+	replay(pWorld, undoStack.back(), true);
+	redoStack.push_back(std::move(undoStack.back()));
+	undoStack.pop_back();
+	return true;
+}
+
+bool EditJournal::redo(World& pWorld) {
+	if (redoStack.empty()) return false;
+
+	replay(pWorld, redoStack.back(), false);
+	undoStack.push_back(std::move(redoStack.back()));
+	redoStack.pop_back();
+	return true;
+}
+
+void EditJournal::replay(World& pWorld, Transaction& pTransaction, bool pUndo) {
+	// The runs become a batch again, so undo goes through the same path as the edit itself
+	EditBatch batch;
+	for (const ChunkDelta& delta : pTransaction.chunks) {
+		loadChunk(pWorld, delta.coordinates);
+		for (const Run& run : delta.runs) {
+			batch.addRun(delta.coordinates, run.start, run.length, pUndo ? run.oldId : run.newId);
+		}
+	}
+
+	pWorld.apply(batch);
+}
+
+void EditJournal::trim() {
+	// The oldest transactions are forgotten first, the latest one is always kept
+	while (bytes > memoryBudget && undoStack.size() > 1) {
+		bytes -= undoStack.front().bytes;
+		undoStack.pop_front();
+	}
+}
+
+void EditJournal::clear() {
+	undoStack.clear();
+	redoStack.clear();
+	bytes = 0;
+}
+
+void EditJournal::setMemoryBudget(size_t pBytes) {
+	memoryBudget = pBytes;
+	trim();
+}
+
+size_t EditJournal::getMemoryBudget() {
+	return memoryBudget;
+}
+
+size_t EditJournal::getMemoryUsage() {
+	return bytes;
+}
+
+int EditJournal::getUndoCount() {
+	return (int)undoStack.size();
+}
+
+int EditJournal::getRedoCount() {
+	return (int)redoStack.size();
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "EditBatch.h"
+
+class World;
+
+// Undo history of edit batches. Each transaction keeps per chunk runs of blocks that went from one id to another.
+class EditJournal {
+public:
+	EditJournal(size_t pMemoryBudget);
+	~EditJournal();
+
+	int apply(World& pWorld, EditBatch& pBatch);
+	bool undo(World& pWorld);
+	bool redo(World& pWorld);
+	void clear();
+
+	void setMemoryBudget(size_t pBytes);
+	size_t getMemoryBudget();
+	size_t getMemoryUsage();
+	int getUndoCount();
+	int getRedoCount();
+
+private:
+	// Consecutive indices that had the same old id and got the same new id
+	struct Run {
+		std::uint32_t start;
+		std::uint32_t length;
+		std::uint8_t oldId;
+		std::uint8_t newId;
+	};
+
+	struct ChunkDelta {
+		glm::ivec3 coordinates;
+		std::vector<Run> runs;
+	};
+
+	struct Transaction {
+		std::vector<ChunkDelta> chunks;
+		size_t bytes;
+	};
+
+	std::deque<Transaction> undoStack;
+	std::vector<Transaction> redoStack;
+	size_t memoryBudget;
+	size_t bytes;
+
+	void replay(World& pWorld, Transaction& pTransaction, bool pUndo);
+	void trim();
+};
\ No newline at end of file
@@ -0,0 +1,333 @@
+#include "EntitySystem.h"
+#include "Collision.h"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENTITY_SYSTEM_SSE
+#include <emmintrin.h>
+#endif
+
+// Entities a worker takes at a time
+static const int blockSize = 1024;
+
+EntitySystem::EntitySystem(World* pWorld, float pTickRate, int pCellSize)
+	: world(pWorld), tickTime(1.0f / pTickRate), accumulator(0.0f), gravity(9.81f), lastTickTime(0.0), drawnCount(0), hash(pWorld, pCellSize), VAO(0), VBO(0),
+	nextBlock(0), tickCount(0), workGeneration(0), busyWorkers(0), stopping(false)
+{
+	threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+EntitySystem::~EntitySystem() {
+	stopWorkers();
+}
+
+int EntitySystem::spawn(glm::vec3 pPosition, glm::vec3 pVelocity, glm::vec3 pHalfSize) {
+	positionX.push_back(pPosition.x);
+	positionY.push_back(pPosition.y);
+	positionZ.push_back(pPosition.z);
+	velocityX.push_back(pVelocity.x);
+	velocityY.push_back(pVelocity.y);
+	velocityZ.push_back(pVelocity.z);
+	halfSizeX.push_back(pHalfSize.x);
+	halfSizeY.push_back(pHalfSize.y);
+	halfSizeZ.push_back(pHalfSize.z);
+	grounded.push_back(0);
+
+	deltaX.push_back(0.0f);
+	deltaY.push_back(0.0f);
+	deltaZ.push_back(0.0f);
+
+	int index = getCount() - 1;
+	hash.insert(index, pPosition);
+	return index;
+}
+
+void EntitySystem::despawn(int pIndex) {
+	// The last entity takes the place of the removed one
+	int last = getCount() - 1;
+	hash.remove(pIndex);
+	if (pIndex != last) {
+		hash.remove(last);
+		hash.insert(pIndex, getPosition(last));
+	}
+
+	std::vector<float>* components[] = { &positionX, &positionY, &positionZ, &velocityX, &velocityY, &velocityZ, &halfSizeX, &halfSizeY, &halfSizeZ, &deltaX, &deltaY, &deltaZ };
+	for (std::vector<float>* component : components) {
+		(*component)[pIndex] = (*component)[last];
+		component->pop_back();
+	}
+	grounded[pIndex] = grounded[last];
+	grounded.pop_back();
+}
+
+void EntitySystem::clear() {
+	std::vector<float>* components[] = { &positionX, &positionY, &positionZ, &velocityX, &velocityY, &velocityZ, &halfSizeX, &halfSizeY, &halfSizeZ, &deltaX, &deltaY, &deltaZ };
+	for (std::vector<float>* component : components) {
+		component->clear();
+	}
+	grounded.clear();
+	hash.clear();
+	accumulator = 0.0f;
+
+	// The buffers are made again when there's something to draw
+	if (VAO) {
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+		VAO = 0;
+		VBO = 0;
+	}
+}
+
+int EntitySystem::update(float pDeltaTime) {
+	// Run as many ticks as fit in the time that passed, dropping time when the simulation can't keep up
+	accumulator += pDeltaTime;
+
+	int ticks = 0;
+	while (accumulator >= tickTime) {
+		if (ticks == 5) {
+			accumulator = 0.0f;
+			break;
+		}
+
+		tick();
+		accumulator -= tickTime;
+		ticks++;
+	}
+	return ticks;
+}
+
+void EntitySystem::tick() {
+	auto start = std::chrono::high_resolution_clock::now();
+	tickCount = getCount();
+	nextBlock = 0;
+
+	// Entities don't affect each other, so the workers take blocks of them. Small amounts aren't worth waking them.
+	int threads = tickCount >= 4096 ? threadCount : 1;
+	if (threads > 1) {
+		if ((int)workers.size() != threads - 1) startWorkers(threads - 1);
+
+		{
+			std::lock_guard<std::mutex> lock(workMutex);
+			workGeneration++;
+			busyWorkers = (int)workers.size();
+		}
+		workStart.notify_all();
+		simulateBlocks();
+
+		std::unique_lock<std::mutex> lock(workMutex);
+		workDone.wait(lock, [this]() { return busyWorkers == 0; });
+	} else {
+		simulateBlocks();
+	}
+	updateHash();
+
+	lastTickTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void EntitySystem::simulateBlocks() {
+	for (int block = nextBlock++; block * blockSize < tickCount; block = nextBlock++) {
+		int blockStart = block * blockSize;
+		int blockEnd = std::min(tickCount, blockStart + blockSize);
+		integrate(blockStart, blockEnd);
+		collide(blockStart, blockEnd);
+	}
+}
+
+void EntitySystem::startWorkers(int pCount) {
+	stopWorkers();
+	for (int i = 0; i < pCount; i++) {
+		workers.emplace_back(&EntitySystem::work, this, workGeneration);
+	}
+}
+
+void EntitySystem::stopWorkers() {
+	{
+		std::lock_guard<std::mutex> lock(workMutex);
+		stopping = true;
+	}
+	workStart.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	stopping = false;
+}
+
+void EntitySystem::work(int pGeneration) {
+	// Every tick raises the generation, which wakes the workers once
+	int generation = pGeneration;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(workMutex);
+			workStart.wait(lock, [this, generation]() { return stopping || workGeneration != generation; });
+			if (stopping) return;
+			generation = workGeneration;
+		}
+
+		simulateBlocks();
+
+		std::lock_guard<std::mutex> lock(workMutex);
+		if (--busyWorkers == 0) workDone.notify_one();
+	}
+}
+
+void EntitySystem::integrate(int pStart, int pEnd) {
+	// Apply gravity and work out how far every entity wants to move this tick
+	int i = pStart;
+#ifdef ENTITY_SYSTEM_SSE
+	__m128 time = _mm_set1_ps(tickTime);
+	__m128 fall = _mm_set1_ps(gravity * tickTime);
+	for (; i + 4 <= pEnd; i += 4) {
+		__m128 velocity = _mm_sub_ps(_mm_loadu_ps(&velocityY[i]), fall);
+		_mm_storeu_ps(&velocityY[i], velocity);
+
+		_mm_storeu_ps(&deltaX[i], _mm_mul_ps(_mm_loadu_ps(&velocityX[i]), time));
+		_mm_storeu_ps(&deltaY[i], _mm_mul_ps(velocity, time));
+		_mm_storeu_ps(&deltaZ[i], _mm_mul_ps(_mm_loadu_ps(&velocityZ[i]), time));
+	}
+#endif
+	for (; i < pEnd; i++) {
+		velocityY[i] -= gravity * tickTime;
+
+		deltaX[i] = velocityX[i] * tickTime;
+		deltaY[i] = velocityY[i] * tickTime;
+		deltaZ[i] = velocityZ[i] * tickTime;
+	}
+}
+
+void EntitySystem::collide(int pStart, int pEnd) {
+	for (int i = pStart; i < pEnd; i++) {
+		glm::vec3 position(positionX[i], positionY[i], positionZ[i]);
+		glm::vec3 halfSize(halfSizeX[i], halfSizeY[i], halfSizeZ[i]);
+
+		AABB box;
+		box.min = position - halfSize;
+		box.max = position + halfSize;
+		CollisionResult result = Collision::move(*world, box, glm::vec3(deltaX[i], deltaY[i], deltaZ[i]));
+
+		positionX[i] += result.delta.x;
+		positionY[i] += result.delta.y;
+		positionZ[i] += result.delta.z;
+
+		// Entities stop moving into what they hit and slow down on the ground
+		if (result.blocked.x) velocityX[i] = 0.0f;
+		if (result.blocked.y) velocityY[i] = 0.0f;
+		if (result.blocked.z) velocityZ[i] = 0.0f;
+		if (result.grounded) {
+			velocityX[i] *= 0.9f;
+			velocityZ[i] *= 0.9f;
+		}
+		grounded[i] = result.grounded ? 1 : 0;
+	}
+}
+
+void EntitySystem::updateHash() {
+	// Only entities that crossed into another cell touch the cells
+	int count = getCount();
+	for (int i = 0; i < count; i++) {
+		hash.move(i, glm::vec3(positionX[i], positionY[i], positionZ[i]));
+	}
+}
+
+void EntitySystem::draw(GLuint pShaderProgram) {
+	drawnCount = 0;
+	int count = getCount();
+	if (count == 0) return;
+
+	if (!VAO) {
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(0);
+	}
+
+	// Entities are drawn as points at their centres. Cells lie within a single chunk, so whole cells are skipped
+	// when their chunk is out of view.
+	std::vector<float> points;
+	points.reserve((size_t)count * 3);
+	std::unordered_map<std::int64_t, bool> visibleChunks;
+	for (auto& pair : hash.getCells()) {
+		glm::ivec3 chunk = hash.getCellChunk(pair.second.coordinates);
+		std::int64_t chunkKey = World::getChunkKey(chunk.x, chunk.y, chunk.z);
+
+		auto it = visibleChunks.find(chunkKey);
+		if (it == visibleChunks.end()) it = visibleChunks.emplace(chunkKey, world->isChunkVisible(chunk)).first;
+		if (!it->second) continue;
+
+		for (int id : pair.second.ids) {
+			points.push_back(positionX[id]);
+			points.push_back(positionY[id]);
+			points.push_back(positionZ[id]);
+		}
+	}
+	drawnCount = (int)(points.size() / 3);
+	if (drawnCount == 0) return;
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(float), points.data(), GL_STREAM_DRAW);
+
+	// Points have a single colour
+	glUniform3f(glGetUniformLocation(pShaderProgram, "col"), 1.0f, 0.5f, 0.0f);
+
+	glPointSize(4.0f);
+	glDrawArrays(GL_POINTS, 0, drawnCount);
+	glBindVertexArray(0);
+}
+
+int EntitySystem::getCount() {
+	return (int)positionX.size();
+}
+
+glm::vec3 EntitySystem::getPosition(int pIndex) {
+	return glm::vec3(positionX[pIndex], positionY[pIndex], positionZ[pIndex]);
+}
+
+glm::vec3 EntitySystem::getHalfSize(int pIndex) {
+	return glm::vec3(halfSizeX[pIndex], halfSizeY[pIndex], halfSizeZ[pIndex]);
+}
+
+bool EntitySystem::isGrounded(int pIndex) {
+	return grounded[pIndex] != 0;
+}
+
+void EntitySystem::queryRadius(glm::vec3 pCentre, float pRadius, std::vector<int>& pResults) {
+	hash.queryRadius(pCentre, pRadius, pResults);
+}
+
+void EntitySystem::queryBox(glm::vec3 pMin, glm::vec3 pMax, std::vector<int>& pResults) {
+	hash.queryBox(pMin, pMax, pResults);
+}
+
+SpatialHash& EntitySystem::getSpatialHash() {
+	return hash;
+}
+
+int EntitySystem::getDrawnCount() {
+	return drawnCount;
+}
+
+void EntitySystem::setThreadCount(int pThreads) {
+	threadCount = std::max(1, pThreads);
+}
+
+int EntitySystem::getThreadCount() {
+	return threadCount;
+}
+
+void EntitySystem::setGravity(float pGravity) {
+	gravity = pGravity;
+}
+
+float EntitySystem::getTickTime() {
+	return tickTime;
+}
+
+double EntitySystem::getLastTickTime() {
+	return lastTickTime;
+}
\ No newline at end of file
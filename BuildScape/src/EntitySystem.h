@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "World.h"
+#include "SpatialHash.h"
+#include "GL/glew.h"
+
+// Boxes that fall and slide through the world. Entities are stored as structure of arrays and
+// simulated with a fixed timestep, independent of the frame rate.
+class EntitySystem {
+public:
+	EntitySystem(World* pWorld, float pTickRate, int pCellSize);
+	~EntitySystem();
+
+	int spawn(glm::vec3 pPosition, glm::vec3 pVelocity, glm::vec3 pHalfSize);
+	void despawn(int pIndex);
+	void clear();
+
+	int update(float pDeltaTime);
+	void tick();
+	void draw(GLuint pShaderProgram);
+
+	int getCount();
+	glm::vec3 getPosition(int pIndex);
+	glm::vec3 getHalfSize(int pIndex);
+	bool isGrounded(int pIndex);
+	void queryRadius(glm::vec3 pCentre, float pRadius, std::vector<int>& pResults);
+	void queryBox(glm::vec3 pMin, glm::vec3 pMax, std::vector<int>& pResults);
+	SpatialHash& getSpatialHash();
+	int getDrawnCount();
+
+	void setThreadCount(int pThreads);
+	int getThreadCount();
+	void setGravity(float pGravity);
+	float getTickTime();
+	double getLastTickTime();
+
+private:
+	World* world;
+	float tickTime;
+	float accumulator;
+	float gravity;
+	int threadCount;
+	double lastTickTime;
+	int drawnCount;
+
+	// Kept up to date after every tick
+	SpatialHash hash;
+
+	// One array per component
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+	std::vector<float> velocityX;
+	std::vector<float> velocityY;
+	std::vector<float> velocityZ;
+	std::vector<float> halfSizeX;
+	std::vector<float> halfSizeY;
+	std::vector<float> halfSizeZ;
+	std::vector<std::uint8_t> grounded;
+
+	// Movement of the current tick, before collision
+	std::vector<float> deltaX;
+	std::vector<float> deltaY;
+	std::vector<float> deltaZ;
+
+	GLuint VAO;
+	GLuint VBO;
+
+	// Workers are started once and woken for every tick, then take blocks of entities until none are left
+	std::vector<std::thread> workers;
+	std::mutex workMutex;
+	std::condition_variable workStart;
+	std::condition_variable workDone;
+	std::atomic<int> nextBlock;
+	int tickCount;
+	int workGeneration;
+	int busyWorkers;
+	bool stopping;
+
+	void integrate(int pStart, int pEnd);
+	void collide(int pStart, int pEnd);
+	void updateHash();
+	void startWorkers(int pCount);
+	void stopWorkers();
+	void work(int pGeneration);
+	void simulateBlocks();
+};
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "FrameRecorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+// Percentile of sorted times by nearest rank
+static double getPercentile(const std::vector<double>& pSorted, double pPercentile) {
+	if (pSorted.empty()) return 0.0;
+
+	int rank = (int)(pPercentile / 100.0 * pSorted.size() + 0.999999) - 1;
+	return pSorted[std::min((int)pSorted.size() - 1, std::max(0, rank))];
+}
+
+FrameRecorder::FrameRecorder(int pCapacity)
+	: nextFrame(0), frameCount(0), recording(false)
+{
+	times.resize(std::max(1, pCapacity), 0.0);
+}
+
+void FrameRecorder::start() {
+	nextFrame = 0;
+	frameCount = 0;
+	recording = true;
+}
+
+void FrameRecorder::stop() {
+	recording = false;
+}
+
+bool FrameRecorder::isRecording() {
+	return recording;
+}
+
+void FrameRecorder::addFrame(double pSeconds) {
+	if (!recording) return;
+
+	times[nextFrame] = pSeconds * 1000.0;
+	nextFrame = (nextFrame + 1) % (int)times.size();
+	frameCount = std::min(frameCount + 1, (int)times.size());
+}
+
+int FrameRecorder::getFrameCount() {
+	return frameCount;
+}
+
+std::vector<double> FrameRecorder::getOrderedTimes() {
+	// Oldest frame first, which is the next one to be overwritten once the buffer is full
+	std::vector<double> ordered;
+	ordered.reserve(frameCount);
+	int first = frameCount < (int)times.size() ? 0 : nextFrame;
+	for (int i = 0; i < frameCount; i++) {
+		ordered.push_back(times[(first + i) % times.size()]);
+	}
+	return ordered;
+}
+
+FrameStatistics FrameRecorder::calculate() {
+	FrameStatistics statistics = {};
+	statistics.frames = frameCount;
+	if (frameCount == 0) return statistics;
+
+	std::vector<double> sorted = getOrderedTimes();
+	std::sort(sorted.begin(), sorted.end());
+
+	for (double time : sorted) {
+		statistics.totalTime += time;
+	}
+	statistics.mean = statistics.totalTime / frameCount;
+	statistics.median = getPercentile(sorted, 50.0);
+	statistics.p95 = getPercentile(sorted, 95.0);
+	statistics.p99 = getPercentile(sorted, 99.0);
+	statistics.worst = sorted.back();
+	statistics.averageFps = statistics.totalTime > 0.0 ? frameCount * 1000.0 / statistics.totalTime : 0.0;
+
+	// The frame rate of only the slowest 1% of the frames
+	int slowest = std::max(1, frameCount / 100);
+	double slowestTime = 0.0;
+	for (int i = frameCount - slowest; i < frameCount; i++) {
+		slowestTime += sorted[i];
+	}
+	statistics.onePercentLowFps = slowestTime > 0.0 ? slowest * 1000.0 / slowestTime : 0.0;
+
+	return statistics;
+}
+
+std::vector<int> FrameRecorder::getHistogram(double pBucketSize, int pBuckets) {
+	// The last bucket also holds everything slower than the buckets cover
+	std::vector<int> histogram(std::max(1, pBuckets), 0);
+	for (double time : getOrderedTimes()) {
+		int bucket = std::min((int)histogram.size() - 1, (int)(time / pBucketSize));
+		histogram[bucket]++;
+	}
+	return histogram;
+}
+
+void FrameRecorder::print() {
+	FrameStatistics statistics = calculate();
+	if (statistics.frames == 0) {
+		std::cout << "No frames were recorded." << std::endl;
+		return;
+	}
+
+	char text[256];
+	snprintf(text, sizeof(text), "Frames: %d in %.2f s\nAverage FPS: %.1f, 1%% low FPS: %.1f\nFrame time: mean %.2f ms, median %.2f ms, p95 %.2f ms, p99 %.2f ms, worst %.2f ms",
+		statistics.frames, statistics.totalTime / 1000.0, statistics.averageFps, statistics.onePercentLowFps,
+		statistics.mean, statistics.median, statistics.p95, statistics.p99, statistics.worst);
+	std::cout << text << std::endl;
+
+	// Histogram of 2 ms buckets, bars are scaled to the fullest bucket
+	const double bucketSize = 2.0;
+	std::vector<int> histogram = getHistogram(bucketSize, 20);
+	int fullest = *std::max_element(histogram.begin(), histogram.end());
+	for (size_t i = 0; i < histogram.size(); i++) {
+		if (histogram[i] == 0) continue;
+
+		if (i + 1 == histogram.size()) snprintf(text, sizeof(text), "%5.0f+    ms %6d ", i * bucketSize, histogram[i]);
+		else snprintf(text, sizeof(text), "%5.0f-%-4.0f ms %6d ", i * bucketSize, (i + 1) * bucketSize, histogram[i]);
+		std::cout << text << std::string(histogram[i] * 40 / fullest, '#') << "\n";
+	}
+}
+
+bool FrameRecorder::writeCsv(const std::string& pPath) {
+	std::ofstream file(pPath);
+	if (!file) {
+		std::cout << "[ERROR] Failed to write " << pPath << std::endl;
+		return false;
+	}
+
+	file << "frame,time_ms\n";
+	std::vector<double> ordered = getOrderedTimes();
+	char line[64];
+	for (size_t i = 0; i < ordered.size(); i++) {
+		snprintf(line, sizeof(line), "%d,%.4f\n", (int)i, ordered[i]);
+		file << line;
+	}
+	return true;
+}
+
+bool FrameRecorder::writeHistogramCsv(const std::string& pPath, double pBucketSize, int pBuckets) {
+	std::ofstream file(pPath);
+	if (!file) {
+		std::cout << "[ERROR] Failed to write " << pPath << std::endl;
+		return false;
+	}
+
+	file << "from_ms,to_ms,frames\n";
+	std::vector<int> histogram = getHistogram(pBucketSize, pBuckets);
+	char line[64];
+	for (size_t i = 0; i < histogram.size(); i++) {
+		// The last bucket has no upper bound
+		if (i + 1 == histogram.size()) snprintf(line, sizeof(line), "%.2f,,%d\n", i * pBucketSize, histogram[i]);
+		else snprintf(line, sizeof(line), "%.2f,%.2f,%d\n", i * pBucketSize, (i + 1) * pBucketSize, histogram[i]);
+		file << line;
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Statistics of recorded frame times, times in milliseconds
+struct FrameStatistics {
+	int frames;
+	double totalTime;
+	double mean;
+	double median;
+	double p95;
+	double p99;
+	double worst;
+	double averageFps;
+	double onePercentLowFps;
+};
+
+// Raw duration of every frame of a recording, kept in a ring buffer so long recordings keep their latest frames.
+// Percentiles and 1% lows show the slow frames that an average hides.
+class FrameRecorder {
+public:
+	FrameRecorder(int pCapacity);
+
+	void start();
+	void stop();
+	bool isRecording();
+	void addFrame(double pSeconds);
+
+	int getFrameCount();
+	FrameStatistics calculate();
+	std::vector<int> getHistogram(double pBucketSize, int pBuckets);
+	void print();
+	bool writeCsv(const std::string& pPath);
+	bool writeHistogramCsv(const std::string& pPath, double pBucketSize, int pBuckets);
+
+private:
+	std::vector<double> getOrderedTimes();
+
+	std::vector<double> times;
+	int nextFrame;
+	int frameCount;
+	bool recording;
+};
\ No newline at end of file
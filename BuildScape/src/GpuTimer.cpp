@@ -0,0 +1,124 @@
+#include "GpuTimer.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Profiler.h"
+
+const int GpuTimer::QUERY_COUNT;
+
+GpuTimer::GpuTimer(const char* pName, int pHistory)
+	: name(pName), nextQuery(0), oldestQuery(0), timing(false), supported(true), nextTime(0), timeCount(0)
+{
+	for (int i = 0; i < QUERY_COUNT; i++) {
+		queries[i] = 0;
+		pending[i] = false;
+	}
+	times.resize(std::max(1, pHistory), 0.0);
+}
+
+GpuTimer::~GpuTimer() {
+	destroy();
+}
+
+void GpuTimer::begin() {
+	if (!supported) return;
+
+	// Queries are made once there's a context
+	if (!queries[0]) {
+		if (!GLEW_ARB_timer_query) {
+			std::cout << "[ERROR] Timer queries aren't supported, " << name << " isn't timed on the GPU." << std::endl;
+			supported = false;
+			return;
+		}
+		glGenQueries(QUERY_COUNT, queries);
+	}
+
+	collect();
+
+	// Waiting for a query would stall, so this frame isn't timed
+	if (pending[nextQuery]) return;
+
+	glBeginQuery(GL_TIME_ELAPSED, queries[nextQuery]);
+	timing = true;
+}
+
+void GpuTimer::end() {
+	if (!timing) return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	pending[nextQuery] = true;
+	nextQuery = (nextQuery + 1) % QUERY_COUNT;
+	timing = false;
+}
+
+void GpuTimer::collect() {
+	// Results come back in the order the queries were made
+	while (pending[oldestQuery]) {
+		GLint available = 0;
+		glGetQueryObjectiv(queries[oldestQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) break;
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(queries[oldestQuery], GL_QUERY_RESULT, &nanoseconds);
+		pending[oldestQuery] = false;
+		oldestQuery = (oldestQuery + 1) % QUERY_COUNT;
+
+		double time = nanoseconds / 1000000.0;
+		times[nextTime] = time;
+		nextTime = (nextTime + 1) % (int)times.size();
+		timeCount = std::min(timeCount + 1, (int)times.size());
+		Profiler::addCounter(name, time);
+	}
+}
+
+void GpuTimer::destroy() {
+	if (!queries[0]) return;
+
+	glDeleteQueries(QUERY_COUNT, queries);
+	for (int i = 0; i < QUERY_COUNT; i++) {
+		queries[i] = 0;
+		pending[i] = false;
+	}
+	nextQuery = 0;
+	oldestQuery = 0;
+	timing = false;
+}
+
+const char* GpuTimer::getName() {
+	return name;
+}
+
+int GpuTimer::getSampleCount() {
+	return timeCount;
+}
+
+double GpuTimer::getLastTime() {
+	if (timeCount == 0) return 0.0;
+	return times[(nextTime + (int)times.size() - 1) % (int)times.size()];
+}
+
+double GpuTimer::getMinTime() {
+	if (timeCount == 0) return 0.0;
+	return *std::min_element(times.begin(), times.begin() + timeCount);
+}
+
+double GpuTimer::getAverageTime() {
+	if (timeCount == 0) return 0.0;
+
+	double total = 0.0;
+	for (int i = 0; i < timeCount; i++) {
+		total += times[i];
+	}
+	return total / timeCount;
+}
+
+double GpuTimer::getPercentileTime(double pPercentile) {
+	if (timeCount == 0) return 0.0;
+
+	// Nearest rank of the sorted times
+	std::vector<double> sorted(times.begin(), times.begin() + timeCount);
+	int rank = std::min(timeCount - 1, (int)(pPercentile / 100.0 * timeCount));
+	std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+	return sorted[rank];
+}
\ No newline at end of file
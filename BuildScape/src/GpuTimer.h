@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "GL/glew.h"
+
+// GPU time of one render pass, measured with GL_TIME_ELAPSED queries.
+// Queries are read back a few frames later when their results are available, so the CPU never waits for the GPU.
+// When every query is still in flight the pass isn't timed that frame.
+class GpuTimer {
+public:
+	GpuTimer(const char* pName, int pHistory);
+	~GpuTimer();
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	void begin();
+	void end();
+	void destroy();
+
+	const char* getName();
+	int getSampleCount();
+	double getLastTime();
+	double getMinTime();
+	double getAverageTime();
+	double getPercentileTime(double pPercentile);
+
+	static const int QUERY_COUNT = 4;
+
+private:
+	void collect();
+
+	const char* name;
+
+	// Queries are used in order, pending ones wait for their result
+	GLuint queries[QUERY_COUNT];
+	bool pending[QUERY_COUNT];
+	int nextQuery;
+	int oldestQuery;
+	bool timing;
+	bool supported;
+
+	// Last results in milliseconds, oldest are overwritten
+	std::vector<double> times;
+	int nextTime;
+	int timeCount;
+};
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 GLFWwindow* Input::window = nullptr;
 std::map<int, bool> Input::keyMemory;
+std::map<int, bool> Input::mouseButtonMemory;
 glm::vec2 Input::mousePosition;
 glm::vec2 Input::lastMousePosition;
 bool Input::firstMouse = true;
@@ -18,6 +19,9 @@ void Input::update() {
 	for (it = keyMemory.begin(); it != keyMemory.end(); it++) {
 		keyMemory[it->first] = getKey(it->first);
 	}
+	for (it = mouseButtonMemory.begin(); it != mouseButtonMemory.end(); it++) {
+		mouseButtonMemory[it->first] = getMouseButton(it->first);
+	}
 
 	lastMousePosition = mousePosition;
 }
@@ -52,6 +56,19 @@ glm::vec2 Input::getDeltaMousePosition() {
 	return mousePosition - lastMousePosition;
 }
 
+bool Input::getMouseButton(int pButton) {
+	return (glfwGetMouseButton(window, pButton) == GLFW_PRESS);
+}
+
+bool Input::getMouseButtonDown(int pButton) {
+	if (mouseButtonMemory.find(pButton) != mouseButtonMemory.end()) {
+		return (!mouseButtonMemory[pButton] && glfwGetMouseButton(window, pButton) == GLFW_PRESS);
+	} else {
+		mouseButtonMemory[pButton] = false;
+		return getMouseButton(pButton);
+	}
+}
+
 void Input::mouseCallback(GLFWwindow* window, double xpos, double ypos) {
 	// Do nothing if we're ignoring the mouse
 	if (ignoreMouse) return;
@@ -70,4 +87,8 @@ void Input::toggleIgnoreMouse() {
 	ignoreMouse = !ignoreMouse;
 	glfwSetInputMode(window, GLFW_CURSOR, ignoreMouse ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
 	//firstMouse = ignoreMouse;
+}
+
+bool Input::isMouseIgnored() {
+	return ignoreMouse;
 }
\ No newline at end of file
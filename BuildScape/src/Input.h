@@ -21,11 +21,15 @@ public:
 	// Mouse
 	static glm::vec2 getMousePosition();
 	static glm::vec2 getDeltaMousePosition();
+	static bool getMouseButton(int pButton);
+	static bool getMouseButtonDown(int pButton);
 	static void mouseCallback(GLFWwindow* window, double xPos, double yPos);
 	static void toggleIgnoreMouse();
+	static bool isMouseIgnored();
 
 private:
 	static std::map<int, bool> keyMemory;
+	static std::map<int, bool> mouseButtonMemory;
 	static GLFWwindow* window;
 
 	static glm::vec2 mousePosition;
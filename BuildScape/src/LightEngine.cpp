@@ -0,0 +1,482 @@
+#include "LightEngine.h"
+#include "World.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// Offset to the neighbouring voxel in the order of the face bits (left, right, down, up, front, back)
+static const int directions[6][3] = {
+	{ -1, 0, 0 },
+	{ 1, 0, 0 },
+	{ 0, -1, 0 },
+	{ 0, 1, 0 },
+	{ 0, 0, -1 },
+	{ 0, 0, 1 }
+};
+
+static int getLevel(std::uint8_t pLight, int pChannel) {
+	return (pLight >> (pChannel * 4)) & 0x0F;
+}
+
+static std::uint8_t withLevel(std::uint8_t pLight, int pChannel, int pLevel) {
+	int shift = pChannel * 4;
+	return (std::uint8_t)((pLight & ~(0x0F << shift)) | (pLevel << shift));
+}
+
+static bool isOpaque(Chunk& pChunk, int pIndex) {
+	return !pChunk.isEmpty() && ((pChunk.getBlocks()[pIndex] >> 12) & 0xFF) != 0;
+}
+
+// Level that reaches the neighbour in a direction, full sky light doesn't get weaker on the way down
+static int getSpread(int pLevel, int pChannel, int pDir) {
+	if (pChannel == 1 && pDir == 2 && pLevel == LightEngine::MAX_LEVEL) return pLevel;
+	return pLevel - 1;
+}
+
+const int LightEngine::MAX_LEVEL;
+
+LightEngine::LightEngine(World* pWorld)
+	: world(pWorld), lastUpdateTime(0.0), lastNodeCount(0), lastChanged(nullptr), lastSides(nullptr)
+{
+	threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+LightEngine::~LightEngine() {
+
+}
+
+void LightEngine::addChunk(Chunk* pChunk) {
+	pChunk->fillLight(0);
+	pendingChunks.insert(pChunk);
+}
+
+void LightEngine::removeChunk(Chunk* pChunk) {
+	pendingChunks.erase(pChunk);
+
+	// Queued light may still refer to the chunk, so it's spread before the chunk goes away
+	for (int channel = 0; channel < 2; channel++) {
+		propagateRemove(channel);
+	}
+	for (int channel = 0; channel < 2; channel++) {
+		propagateAdd(channel);
+	}
+	markChanged();
+}
+
+void LightEngine::relightAll() {
+	for (int channel = 0; channel < 2; channel++) {
+		addQueues[channel].clear();
+		removeQueues[channel].clear();
+	}
+
+	for (auto& pair : world->getChunks()) {
+		addChunk(pair.second.get());
+	}
+}
+
+void LightEngine::blockChanged(Chunk* pChunk, int pIndex) {
+	// Chunks that are lit from scratch don't need the queues
+	if (pendingChunks.count(pChunk)) return;
+
+	bool opaque = isOpaque(*pChunk, pIndex);
+	for (int channel = 0; channel < 2; channel++) {
+		// The old light goes away first, together with the light that came from it
+		int level = getLevel(pChunk->getLight(pIndex), channel);
+		if (level > 0) {
+			setLevel(*pChunk, pIndex, channel, 0);
+			removeQueues[channel].push_back({ pChunk, pIndex, level });
+		}
+
+		// Then the voxel takes light from its source and, when light can get in, from its neighbours
+		int source = getSource(*pChunk, pIndex, channel);
+		if (source > 0) {
+			setLevel(*pChunk, pIndex, channel, source);
+			addQueues[channel].push_back({ pChunk, pIndex, 0 });
+		}
+		if (opaque) continue;
+
+		for (int dir = 0; dir < 6; dir++) {
+			int neighbourIndex;
+			Chunk* neighbour = getNeighbour(*pChunk, pIndex, dir, neighbourIndex);
+			if (neighbour && getLevel(neighbour->getLight(neighbourIndex), channel) > 0) addQueues[channel].push_back({ neighbour, neighbourIndex, 0 });
+		}
+	}
+}
+
+int LightEngine::update() {
+	bool queued = !pendingChunks.empty();
+	for (int channel = 0; channel < 2; channel++) {
+		queued |= !addQueues[channel].empty() || !removeQueues[channel].empty();
+	}
+	if (!queued) return 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	lastNodeCount = 0;
+	if (!pendingChunks.empty()) lightPending();
+
+	// Everything that lost its light is cleared before light spreads again
+	for (int channel = 0; channel < 2; channel++) {
+		propagateRemove(channel);
+	}
+	for (int channel = 0; channel < 2; channel++) {
+		propagateAdd(channel);
+	}
+	markChanged();
+
+	lastUpdateTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	return lastNodeCount;
+}
+
+void LightEngine::clear() {
+	pendingChunks.clear();
+	for (int channel = 0; channel < 2; channel++) {
+		addQueues[channel].clear();
+		removeQueues[channel].clear();
+	}
+	changedChunks.clear();
+	lastChanged = nullptr;
+}
+
+void LightEngine::lightPending() {
+	// Columns are lit top down, so sky light falls through a whole column on one thread
+	std::unordered_map<std::int64_t, std::vector<Chunk*>> columnChunks;
+	for (Chunk* chunk : pendingChunks) {
+		glm::ivec3 coordinates = chunk->getCoordinates();
+		columnChunks[World::getChunkKey(coordinates.x, 0, coordinates.z)].push_back(chunk);
+	}
+
+	std::vector<std::vector<Chunk*>> columns;
+	columns.reserve(columnChunks.size());
+	for (auto& pair : columnChunks) {
+		std::vector<Chunk*>& column = pair.second;
+		std::sort(column.begin(), column.end(), [](Chunk* a, Chunk* b) {
+			return a->getCoordinates().y > b->getCoordinates().y;
+		});
+		columns.push_back(std::move(column));
+	}
+
+	// Columns don't write to each other's chunks, so workers take them until there are none left
+	std::atomic<int> nextColumn(0);
+	std::vector<std::thread> workers;
+	int threads = std::min(threadCount, (int)columns.size());
+	for (int i = 1; i < threads; i++) {
+		workers.emplace_back(&LightEngine::lightColumns, this, std::ref(columns), std::ref(nextColumn));
+	}
+	lightColumns(columns, nextColumn);
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	// Light crosses the borders with the rest of the world through the shared queues
+	for (Chunk* chunk : pendingChunks) {
+		reconcileBelow(*chunk);
+		seedBorders(*chunk);
+		changedChunks[chunk] |= 0x3F;
+	}
+	pendingChunks.clear();
+}
+
+void LightEngine::lightColumns(std::vector<std::vector<Chunk*>>& pColumns, std::atomic<int>& pNextColumn) {
+	for (int column = pNextColumn++; column < (int)pColumns.size(); column = pNextColumn++) {
+		for (Chunk* chunk : pColumns[column]) {
+			lightChunk(*chunk);
+		}
+	}
+}
+
+void LightEngine::lightChunk(Chunk& pChunk) {
+	// Sky light comes in through the top, where there's no chunk above the sky is open
+	glm::ivec3 coordinates = pChunk.getCoordinates();
+	Chunk* above = world->getChunk(coordinates.x, coordinates.y + 1, coordinates.z);
+	std::vector<int> incoming(Chunk::LAYER, MAX_LEVEL);
+	bool open = true;
+	if (above) {
+		for (int i = 0; i < Chunk::LAYER; i++) {
+			incoming[i] = std::max(0, getSpread(getLevel(above->getLight(i), 1), 1, 2));
+			open &= incoming[i] == MAX_LEVEL;
+		}
+	}
+
+	// Chunks of air under the open sky are lit all the way through
+	bool empty = pChunk.isEmpty();
+	if (empty && open) {
+		pChunk.fillLight(withLevel(0, 1, MAX_LEVEL));
+		return;
+	}
+	pChunk.fillLight(0);
+
+	// Full sky light falls down each column until it hits a block, weaker light only enters the top voxel
+	std::vector<Node> queues[2];
+	for (int i = 0; i < Chunk::LAYER; i++) {
+		int level = incoming[i];
+		if (level <= 0) continue;
+
+		for (int y = Chunk::SIZE_Y - 1; y >= 0; y--) {
+			int index = y * Chunk::LAYER + i;
+			if (isOpaque(pChunk, index)) break;
+
+			pChunk.setLight(index, withLevel(pChunk.getLight(index), 1, level));
+			if (level < MAX_LEVEL) {
+				queues[1].push_back({ &pChunk, index, 0 });
+				break;
+			}
+		}
+	}
+
+	// Fully lit voxels only have to spread sideways where there's a darker voxel next to them
+	for (int index = 0; index < Chunk::VOLUME; index++) {
+		if (getLevel(pChunk.getLight(index), 1) != MAX_LEVEL) continue;
+
+		int x = Chunk::getX(index);
+		int z = Chunk::getZ(index);
+		int sides[4] = { x > 0 ? index - 1 : -1, x < Chunk::SIZE_X - 1 ? index + 1 : -1, z > 0 ? index - Chunk::ROW : -1, z < Chunk::SIZE_Z - 1 ? index + Chunk::ROW : -1 };
+		for (int side : sides) {
+			if (side >= 0 && getLevel(pChunk.getLight(side), 1) < MAX_LEVEL - 1 && !isOpaque(pChunk, side)) {
+				queues[1].push_back({ &pChunk, index, 0 });
+				break;
+			}
+		}
+	}
+
+	// Blocks that glow
+	if (!empty) {
+		std::vector<std::uint32_t>& blocks = pChunk.getBlocks();
+		for (int index = 0; index < Chunk::VOLUME; index++) {
+			int emission = getEmission((blocks[index] >> 12) & 0xFF);
+			if (emission == 0) continue;
+
+			pChunk.setLight(index, withLevel(pChunk.getLight(index), 0, emission));
+			queues[0].push_back({ &pChunk, index, 0 });
+		}
+	}
+
+	// Spread within the chunk, light crosses the borders after all chunks are done
+	for (int channel = 0; channel < 2; channel++) {
+		std::vector<Node>& queue = queues[channel];
+		for (size_t head = 0; head < queue.size(); head++) {
+			int index = queue[head].index;
+			int level = getLevel(pChunk.getLight(index), channel);
+			int x = Chunk::getX(index);
+			int y = Chunk::getY(index);
+			int z = Chunk::getZ(index);
+
+			for (int dir = 0; dir < 6; dir++) {
+				int nX = x + directions[dir][0];
+				int nY = y + directions[dir][1];
+				int nZ = z + directions[dir][2];
+				if (nX < 0 || nX >= Chunk::SIZE_X || nY < 0 || nY >= Chunk::SIZE_Y || nZ < 0 || nZ >= Chunk::SIZE_Z) continue;
+
+				int neighbour = Chunk::getIndex(nX, nY, nZ);
+				int spread = getSpread(level, channel, dir);
+				if (spread <= 0 || isOpaque(pChunk, neighbour)) continue;
+
+				std::uint8_t light = pChunk.getLight(neighbour);
+				if (getLevel(light, channel) >= spread) continue;
+
+				pChunk.setLight(neighbour, withLevel(light, channel, spread));
+				queue.push_back({ &pChunk, neighbour, 0 });
+			}
+		}
+	}
+
+	pChunk.compactLight();
+}
+
+void LightEngine::reconcileBelow(Chunk& pChunk) {
+	// The chunk below was lit as if the sky above it was open
+	glm::ivec3 coordinates = pChunk.getCoordinates();
+	Chunk* below = world->getChunk(coordinates.x, coordinates.y - 1, coordinates.z);
+	if (!below || pendingChunks.count(below)) return;
+
+	for (int i = 0; i < Chunk::LAYER; i++) {
+		int top = (Chunk::SIZE_Y - 1) * Chunk::LAYER + i;
+		if (getLevel(below->getLight(top), 1) != MAX_LEVEL || getLevel(pChunk.getLight(i), 1) == MAX_LEVEL) continue;
+
+		setLevel(*below, top, 1, 0);
+		removeQueues[1].push_back({ below, top, MAX_LEVEL });
+	}
+}
+
+void LightEngine::seedBorders(Chunk& pChunk) {
+	glm::ivec3 coordinates = pChunk.getCoordinates();
+	glm::ivec3 dimensions = World::getChunkDimensions();
+
+	for (int dir = 0; dir < 6; dir++) {
+		Chunk* neighbour = world->getChunk(coordinates.x + directions[dir][0], coordinates.y + directions[dir][1], coordinates.z + directions[dir][2]);
+		if (!neighbour) continue;
+
+		// Light can't flow between two chunks that are lit the same all the way through
+		if (pChunk.isLightUniform() && neighbour->isLightUniform() && pChunk.getLight(0) == neighbour->getLight(0)) continue;
+
+		// Neighbours that were lit from scratch as well spread their own side
+		bool both = !pendingChunks.count(neighbour);
+		int axis = dir / 2;
+		int axisA = (axis + 1) % 3;
+		int axisB = (axis + 2) % 3;
+
+		for (int a = 0; a < dimensions[axisA]; a++) {
+			for (int b = 0; b < dimensions[axisB]; b++) {
+				glm::ivec3 local;
+				local[axisA] = a;
+				local[axisB] = b;
+				local[axis] = dir % 2 == 0 ? 0 : dimensions[axis] - 1;
+				int index = Chunk::getIndex(local.x, local.y, local.z);
+
+				local[axis] = dir % 2 == 0 ? dimensions[axis] - 1 : 0;
+				int neighbourIndex = Chunk::getIndex(local.x, local.y, local.z);
+
+				for (int channel = 0; channel < 2; channel++) {
+					if (getLevel(pChunk.getLight(index), channel) > 1) addQueues[channel].push_back({ &pChunk, index, 0 });
+					if (both && getLevel(neighbour->getLight(neighbourIndex), channel) > 1) addQueues[channel].push_back({ neighbour, neighbourIndex, 0 });
+				}
+			}
+		}
+	}
+}
+
+void LightEngine::propagateRemove(int pChannel) {
+	std::vector<Node>& queue = removeQueues[pChannel];
+	for (size_t head = 0; head < queue.size(); head++) {
+		Node node = queue[head];
+
+		for (int dir = 0; dir < 6; dir++) {
+			int neighbourIndex;
+			Chunk* neighbour = getNeighbour(*node.chunk, node.index, dir, neighbourIndex);
+			if (!neighbour) continue;
+
+			int level = getLevel(neighbour->getLight(neighbourIndex), pChannel);
+			if (level == 0) continue;
+
+			// Neighbours that could have their light from here lose it too, brighter ones spread theirs back in afterwards
+			if (level <= getSpread(node.level, pChannel, dir)) {
+				setLevel(*neighbour, neighbourIndex, pChannel, 0);
+				queue.push_back({ neighbour, neighbourIndex, level });
+
+				int source = getSource(*neighbour, neighbourIndex, pChannel);
+				if (source > 0) {
+					setLevel(*neighbour, neighbourIndex, pChannel, source);
+					addQueues[pChannel].push_back({ neighbour, neighbourIndex, 0 });
+				}
+			} else {
+				addQueues[pChannel].push_back({ neighbour, neighbourIndex, 0 });
+			}
+		}
+	}
+
+	lastNodeCount += (int)queue.size();
+	queue.clear();
+}
+
+void LightEngine::propagateAdd(int pChannel) {
+	std::vector<Node>& queue = addQueues[pChannel];
+	for (size_t head = 0; head < queue.size(); head++) {
+		Node node = queue[head];
+		int level = getLevel(node.chunk->getLight(node.index), pChannel);
+
+		for (int dir = 0; dir < 6; dir++) {
+			int spread = getSpread(level, pChannel, dir);
+			if (spread <= 0) continue;
+
+			int neighbourIndex;
+			Chunk* neighbour = getNeighbour(*node.chunk, node.index, dir, neighbourIndex);
+			if (!neighbour || isOpaque(*neighbour, neighbourIndex)) continue;
+			if (getLevel(neighbour->getLight(neighbourIndex), pChannel) >= spread) continue;
+
+			setLevel(*neighbour, neighbourIndex, pChannel, spread);
+			queue.push_back({ neighbour, neighbourIndex, 0 });
+		}
+	}
+
+	lastNodeCount += (int)queue.size();
+	queue.clear();
+}
+
+void LightEngine::markChanged() {
+	// Faces show the light of the voxel in front of them, which can be in the next chunk
+	for (auto& pair : changedChunks) {
+		Chunk& chunk = *pair.first;
+		world->markMeshDirty(chunk);
+
+		glm::ivec3 coordinates = chunk.getCoordinates();
+		for (int dir = 0; dir < 6; dir++) {
+			if (!(pair.second & (1 << dir))) continue;
+
+			Chunk* neighbour = world->getChunk(coordinates.x + directions[dir][0], coordinates.y + directions[dir][1], coordinates.z + directions[dir][2]);
+			if (neighbour) world->markMeshDirty(*neighbour);
+		}
+	}
+
+	changedChunks.clear();
+	lastChanged = nullptr;
+}
+
+Chunk* LightEngine::getNeighbour(Chunk& pChunk, int pIndex, int pDir, int& pNeighbourIndex) {
+	int x = Chunk::getX(pIndex) + directions[pDir][0];
+	int y = Chunk::getY(pIndex) + directions[pDir][1];
+	int z = Chunk::getZ(pIndex) + directions[pDir][2];
+	if (x >= 0 && x < Chunk::SIZE_X && y >= 0 && y < Chunk::SIZE_Y && z >= 0 && z < Chunk::SIZE_Z) {
+		pNeighbourIndex = Chunk::getIndex(x, y, z);
+		return &pChunk;
+	}
+
+	// Voxels on the border look into the neighbouring chunk
+	glm::ivec3 coordinates = pChunk.getCoordinates();
+	pNeighbourIndex = Chunk::getIndex((x + Chunk::SIZE_X) % Chunk::SIZE_X, (y + Chunk::SIZE_Y) % Chunk::SIZE_Y, (z + Chunk::SIZE_Z) % Chunk::SIZE_Z);
+	return world->getChunk(coordinates.x + directions[pDir][0], coordinates.y + directions[pDir][1], coordinates.z + directions[pDir][2]);
+}
+
+int LightEngine::getSource(Chunk& pChunk, int pIndex, int pChannel) {
+	if (pChannel == 0) return pChunk.isEmpty() ? 0 : getEmission((pChunk.getBlocks()[pIndex] >> 12) & 0xFF);
+
+	// The top of a chunk without a chunk above is open to the sky
+	if (Chunk::getY(pIndex) != Chunk::SIZE_Y - 1 || isOpaque(pChunk, pIndex)) return 0;
+
+	glm::ivec3 coordinates = pChunk.getCoordinates();
+	return world->getChunk(coordinates.x, coordinates.y + 1, coordinates.z) ? 0 : MAX_LEVEL;
+}
+
+void LightEngine::setLevel(Chunk& pChunk, int pIndex, int pChannel, int pLevel) {
+	pChunk.setLight(pIndex, withLevel(pChunk.getLight(pIndex), pChannel, pLevel));
+
+	// Remember which borders the change is on, the neighbours there have faces showing this voxel's light
+	int x = Chunk::getX(pIndex);
+	int y = Chunk::getY(pIndex);
+	int z = Chunk::getZ(pIndex);
+	int sides = (x == 0 ? 1 : 0) | (x == Chunk::SIZE_X - 1 ? 2 : 0) | (y == 0 ? 4 : 0) | (y == Chunk::SIZE_Y - 1 ? 8 : 0)
+		| (z == 0 ? 16 : 0) | (z == Chunk::SIZE_Z - 1 ? 32 : 0);
+
+	if (&pChunk != lastChanged) {
+		lastChanged = &pChunk;
+		lastSides = &changedChunks[&pChunk];
+	}
+	*lastSides |= sides;
+}
+
+int LightEngine::getEmission(std::uint8_t pId) {
+	// Lamps are the only blocks that glow
+	return pId == 3 ? 14 : 0;
+}
+
+float LightEngine::getBrightness(std::uint8_t pLight) {
+	// Every level is a bit darker than the one above it, same as the chunk shader
+	int level = std::max(getLevel(pLight, 0), getLevel(pLight, 1));
+	return std::pow(0.8f, (float)(MAX_LEVEL - level));
+}
+
+void LightEngine::setThreadCount(int pThreads) {
+	threadCount = std::max(1, pThreads);
+}
+
+int LightEngine::getThreadCount() {
+	return threadCount;
+}
+
+double LightEngine::getLastUpdateTime() {
+	return lastUpdateTime;
+}
+
+int LightEngine::getLastNodeCount() {
+	return lastNodeCount;
+}
\ No newline at end of file
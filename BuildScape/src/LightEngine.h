@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Chunk.h"
+
+class World;
+
+// Sky light and block light of every voxel, spread by flood fill across chunk borders.
+// Light drops by one level per voxel, except full sky light, which falls straight down without getting weaker.
+// Chunks are lit from scratch when they're added, block edits only update the light around them.
+class LightEngine {
+public:
+	LightEngine(World* pWorld);
+	~LightEngine();
+
+	void addChunk(Chunk* pChunk);
+	void removeChunk(Chunk* pChunk);
+	void relightAll();
+	void blockChanged(Chunk* pChunk, int pIndex);
+	int update();
+	void clear();
+
+	static int getEmission(std::uint8_t pId);
+	static float getBrightness(std::uint8_t pLight);
+
+	void setThreadCount(int pThreads);
+	int getThreadCount();
+	double getLastUpdateTime();
+	int getLastNodeCount();
+
+	static const int MAX_LEVEL = 15;
+
+private:
+	// Channel 0 is block light, channel 1 is sky light
+	struct Node {
+		Chunk* chunk;
+		int index;
+		int level;
+	};
+
+	World* world;
+	int threadCount;
+	double lastUpdateTime;
+	int lastNodeCount;
+
+	// Chunks that still have to be lit from scratch
+	std::unordered_set<Chunk*> pendingChunks;
+
+	std::vector<Node> addQueues[2];
+	std::vector<Node> removeQueues[2];
+
+	// Chunks with changed light and the sides where the change touched the border, their meshes are rebuilt
+	std::unordered_map<Chunk*, int> changedChunks;
+	Chunk* lastChanged;
+	int* lastSides;
+
+	void lightPending();
+	void lightColumns(std::vector<std::vector<Chunk*>>& pColumns, std::atomic<int>& pNextColumn);
+	void lightChunk(Chunk& pChunk);
+	void reconcileBelow(Chunk& pChunk);
+	void seedBorders(Chunk& pChunk);
+	void propagateRemove(int pChannel);
+	void propagateAdd(int pChannel);
+	void markChanged();
+
+	Chunk* getNeighbour(Chunk& pChunk, int pIndex, int pDir, int& pNeighbourIndex);
+	int getSource(Chunk& pChunk, int pIndex, int pChannel);
+	void setLevel(Chunk& pChunk, int pIndex, int pChannel, int pLevel);
+};
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile()
+	: data(nullptr), size(0), file(INVALID_HANDLE_VALUE), mapping(nullptr)
+{
+
+}
+#else
+MappedFile::MappedFile()
+	: data(nullptr), size(0), file(-1)
+{
+
+}
+#endif
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const std::string& pPath) {
+	close();
+
+#ifdef _WIN32
+	// Share writing, region files are appended to while they're mapped
+	file = CreateFileA(pPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		close();
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		close();
+		return false;
+	}
+
+	data = (const std::uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	file = ::open(pPath.c_str(), O_RDONLY);
+	if (file < 0) return false;
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0) {
+		close();
+		return false;
+	}
+	size = (size_t)fileStat.st_size;
+
+	void* view = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+	data = view == MAP_FAILED ? nullptr : (const std::uint8_t*)view;
+
+	// Chunks are read in any order, so don't let the kernel read ahead on its own
+	if (data) madvise(view, size, MADV_RANDOM);
+#endif
+
+	if (!data) {
+		std::cout << "[ERROR] Mapping " << pPath << " failed." << std::endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+	if (data) UnmapViewOfFile(data);
+	if (mapping) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+	mapping = nullptr;
+	file = INVALID_HANDLE_VALUE;
+#else
+	if (data) munmap((void*)data, size);
+	if (file >= 0) ::close(file);
+	file = -1;
+#endif
+
+	data = nullptr;
+	size = 0;
+}
+
+bool MappedFile::isOpen() {
+	return data != nullptr;
+}
+
+const std::uint8_t* MappedFile::getData() {
+	return data;
+}
+
+size_t MappedFile::getSize() {
+	return size;
+}
+
+void MappedFile::prefetch(size_t pOffset, size_t pLength) {
+	if (!data || pOffset >= size) return;
+	if (pLength > size - pOffset) pLength = size - pOffset;
+
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = (PVOID)(data + pOffset);
+	range.NumberOfBytes = pLength;
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	// madvise wants a page aligned address
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t start = pOffset / page * page;
+	madvise((void*)(data + start), pLength + (pOffset - start), MADV_WILLNEED);
+#endif
+}
\ No newline at end of file
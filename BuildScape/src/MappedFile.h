@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a file, pages are only read from disk once they are touched
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const std::string& pPath);
+	void close();
+	bool isOpen();
+
+	const std::uint8_t* getData();
+	size_t getSize();
+	void prefetch(size_t pOffset, size_t pLength);
+
+private:
+	const std::uint8_t* data;
+	size_t size;
+
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#else
+	int file;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "Octree.h"
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+const std::uint32_t Octree::UNIFORM;
+
+// Hashes the children of a node, so identical nodes can be found while deduplicating
+struct NodeHash {
+	size_t operator()(const std::vector<std::uint32_t>& pChildren) const {
+		size_t hash = 2166136261u;
+		for (std::uint32_t child : pChildren) {
+			hash = (hash ^ child) * 16777619u;
+		}
+		return hash;
+	}
+};
+
+Octree::Octree(int pDepth)
+	: root(UNIFORM), depth(pDepth)
+{
+
+}
+
+Octree::~Octree() {
+
+}
+
+bool Octree::set(glm::ivec3 pPosition, std::uint8_t pId) {
+	if (!contains(pPosition)) {
+		std::cout << "[ERROR] Voxel (" << pPosition.x << ", " << pPosition.y << ", " << pPosition.z << ") is outside the octree, which covers "
+			<< -getSize() / 2 << " to " << getSize() / 2 - 1 << " along each axis." << std::endl;
+		return false;
+	}
+
+	// Voxel coordinates are centred on the middle of the tree
+	root = setRecursive(root, getSize(), pPosition + glm::ivec3(getSize() / 2), pId);
+	return true;
+}
+
+std::uint8_t Octree::get(glm::ivec3 pPosition) {
+	if (!contains(pPosition)) return 0;
+
+	// Walk down until we reach a uniform subtree
+	glm::ivec3 local = pPosition + glm::ivec3(getSize() / 2);
+	std::uint32_t reference = root;
+	int size = getSize();
+	while (!(reference & UNIFORM)) {
+		size /= 2;
+		int child = (local.x >= size ? 1 : 0) | (local.y >= size ? 2 : 0) | (local.z >= size ? 4 : 0);
+		local %= size;
+		reference = nodes[reference].children[child];
+	}
+
+	return reference & 0xFF;
+}
+
+bool Octree::contains(glm::ivec3 pPosition) {
+	glm::ivec3 local = pPosition + glm::ivec3(getSize() / 2);
+	return glm::all(glm::greaterThanEqual(local, glm::ivec3(0))) && glm::all(glm::lessThan(local, glm::ivec3(getSize())));
+}
+
+void Octree::forEach(glm::ivec3 pMin, glm::ivec3 pMax, std::function<void(glm::ivec3, std::uint8_t)> pFunction) {
+	forEachRecursive(root, glm::ivec3(-getSize() / 2), getSize(), pMin, pMax, pFunction);
+}
+
+void Octree::deduplicate() {
+	std::vector<Node> oldNodes;
+	oldNodes.swap(nodes);
+	freeNodes.clear();
+
+	std::unordered_map<std::vector<std::uint32_t>, std::uint32_t, NodeHash> unique;
+	std::vector<std::uint32_t> remap(oldNodes.size(), UNIFORM);
+	std::vector<bool> visited(oldNodes.size(), false);
+
+	// Rebuild the pool bottom up, children before their parents
+	std::function<std::uint32_t(std::uint32_t)> intern = [&](std::uint32_t pReference) -> std::uint32_t {
+		if (pReference & UNIFORM) return pReference;
+		if (visited[pReference]) return remap[pReference];
+
+		std::vector<std::uint32_t> children(8);
+		for (int i = 0; i < 8; i++) {
+			children[i] = intern(oldNodes[pReference].children[i]);
+		}
+
+		// Nodes whose children are all the same uniform subtree collapse into it
+		std::uint32_t result;
+		if ((children[0] & UNIFORM) && std::all_of(children.begin(), children.end(), [&](std::uint32_t c) { return c == children[0]; })) {
+			result = children[0];
+		} else {
+			auto it = unique.find(children);
+			if (it != unique.end()) {
+				result = it->second;
+			} else {
+				result = (std::uint32_t)nodes.size();
+				Node node;
+				std::copy(children.begin(), children.end(), node.children);
+				node.references = 0;
+				nodes.push_back(node);
+				unique[children] = result;
+			}
+		}
+
+		visited[pReference] = true;
+		remap[pReference] = result;
+		return result;
+	};
+
+	root = intern(root);
+	nodes.shrink_to_fit();
+
+	// Every node is referenced by each parent that kept it, and the root by the tree itself
+	for (const Node& node : nodes) {
+		for (std::uint32_t child : node.children) {
+			if (!(child & UNIFORM)) nodes[child].references++;
+		}
+	}
+	if (!(root & UNIFORM)) nodes[root].references++;
+}
+
+void Octree::clear() {
+	nodes.clear();
+	freeNodes.clear();
+	root = UNIFORM;
+}
+
+int Octree::getSize() {
+	return 1 << depth;
+}
+
+size_t Octree::getNodeCount() {
+	return nodes.size() - freeNodes.size();
+}
+
+size_t Octree::getMemoryUsage() {
+	return sizeof(Octree) + nodes.capacity() * sizeof(Node) + freeNodes.capacity() * sizeof(std::uint32_t);
+}
+
+std::uint32_t Octree::createNode(std::uint32_t pChild) {
+	Node node;
+	std::fill(node.children, node.children + 8, pChild);
+	node.references = 1;
+
+	if (!freeNodes.empty()) {
+		std::uint32_t index = freeNodes.back();
+		freeNodes.pop_back();
+		nodes[index] = node;
+		return index;
+	}
+
+	nodes.push_back(node);
+	return (std::uint32_t)nodes.size() - 1;
+}
+
+void Octree::release(std::uint32_t pReference) {
+	if (pReference & UNIFORM) return;
+	if (--nodes[pReference].references > 0) return;
+
+	for (std::uint32_t child : nodes[pReference].children) {
+		release(child);
+	}
+	freeNodes.push_back(pReference);
+}
+
+std::uint32_t Octree::setRecursive(std::uint32_t pReference, int pSize, glm::ivec3 pPosition, std::uint8_t pId) {
+	// The caller's reference is handed over, the returned one belongs to the caller
+	if (pSize == 1) return UNIFORM | pId;
+
+	// Nothing changes if the subtree already is this id
+	if ((pReference & UNIFORM) && (pReference & 0xFF) == pId) return pReference;
+
+	// Split uniform subtrees, and copy nodes that are shared by other parents
+	std::uint32_t index;
+	if (pReference & UNIFORM) {
+		index = createNode(pReference);
+	} else if (nodes[pReference].references > 1) {
+		Node copy = nodes[pReference];
+		for (std::uint32_t child : copy.children) {
+			if (!(child & UNIFORM)) nodes[child].references++;
+		}
+		nodes[pReference].references--;
+
+		index = createNode(0);
+		std::copy(copy.children, copy.children + 8, nodes[index].children);
+	} else {
+		index = pReference;
+	}
+
+	int half = pSize / 2;
+	int child = (pPosition.x >= half ? 1 : 0) | (pPosition.y >= half ? 2 : 0) | (pPosition.z >= half ? 4 : 0);
+	std::uint32_t result = setRecursive(nodes[index].children[child], half, pPosition % half, pId);
+	nodes[index].children[child] = result;
+
+	// Collapse the node again if all its children are the same id
+	if (result & UNIFORM) {
+		const std::uint32_t* children = nodes[index].children;
+		if (std::all_of(children, children + 8, [result](std::uint32_t c) { return c == result; })) {
+			freeNodes.push_back(index);
+			return result;
+		}
+	}
+
+	return index;
+}
+
+void Octree::forEachRecursive(std::uint32_t pReference, glm::ivec3 pOrigin, int pSize, glm::ivec3 pMin, glm::ivec3 pMax,
+	std::function<void(glm::ivec3, std::uint8_t)>& pFunction) {
+	// Skip subtrees outside the region
+	glm::ivec3 low = glm::max(pOrigin, pMin);
+	glm::ivec3 high = glm::min(pOrigin + glm::ivec3(pSize), pMax);
+	if (glm::any(glm::greaterThanEqual(low, high))) return;
+
+	if (pReference & UNIFORM) {
+		// Air is skipped entirely, other ids report every voxel in the region
+		std::uint8_t id = pReference & 0xFF;
+		if (id == 0) return;
+
+		for (int y = low.y; y < high.y; y++) {
+			for (int z = low.z; z < high.z; z++) {
+				for (int x = low.x; x < high.x; x++) {
+					pFunction(glm::ivec3(x, y, z), id);
+				}
+			}
+		}
+		return;
+	}
+
+	int half = pSize / 2;
+	for (int i = 0; i < 8; i++) {
+		glm::ivec3 origin = pOrigin + glm::ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1) * half;
+		forEachRecursive(nodes[pReference].children[i], origin, half, pMin, pMax, pFunction);
+	}
+}
\ No newline at end of file
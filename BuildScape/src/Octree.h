@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// Sparse voxel octree holding a block id per voxel.
+//
+// Children are referenced by 32 bit values. A reference either points at a node in the pool or, with the
+// top bit set, describes a subtree filled with a single id. Large areas of air or stone therefore cost a
+// single reference. deduplicate() turns the tree into a DAG where identical subtrees are stored only once.
+// Nodes count the parents that reference them, edits copy shared nodes along their path and nodes are
+// freed once nothing references them anymore.
+class Octree {
+public:
+	Octree(int pDepth);
+	~Octree();
+
+	bool set(glm::ivec3 pPosition, std::uint8_t pId);
+	std::uint8_t get(glm::ivec3 pPosition);
+	bool contains(glm::ivec3 pPosition);
+	void forEach(glm::ivec3 pMin, glm::ivec3 pMax, std::function<void(glm::ivec3, std::uint8_t)> pFunction);
+
+	void deduplicate();
+	void clear();
+
+	int getSize();
+	size_t getNodeCount();
+	size_t getMemoryUsage();
+
+private:
+	static const std::uint32_t UNIFORM = 0x80000000;
+
+	struct Node {
+		std::uint32_t children[8];
+		std::uint32_t references;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<std::uint32_t> freeNodes;
+	std::uint32_t root;
+	int depth;
+
+	std::uint32_t createNode(std::uint32_t pChild);
+	void release(std::uint32_t pReference);
+	std::uint32_t setRecursive(std::uint32_t pReference, int pSize, glm::ivec3 pPosition, std::uint8_t pId);
+	void forEachRecursive(std::uint32_t pReference, glm::ivec3 pOrigin, int pSize, glm::ivec3 pMin, glm::ivec3 pMax,
+		std::function<void(glm::ivec3, std::uint8_t)>& pFunction);
+};
\ No newline at end of file
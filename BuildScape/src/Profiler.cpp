@@ -0,0 +1,188 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "imgui/imgui.h"
+
+bool Profiler::enabled = true;
+std::vector<ProfileZone> Profiler::zones;
+std::vector<ProfileZone> Profiler::lastFrame;
+double Profiler::frameStart = 0.0;
+double Profiler::lastFrameStart = 0.0;
+double Profiler::lastFrameTime = 0.0;
+int Profiler::depth = 0;
+std::vector<ProfileZone> Profiler::captured;
+std::vector<ProfileCounter> Profiler::counters;
+std::vector<ProfileCounter> Profiler::capturedCounters;
+int Profiler::captureFrames = 0;
+std::string Profiler::capturePath;
+
+static const auto profilerStart = std::chrono::high_resolution_clock::now();
+
+double Profiler::now() {
+	return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - profilerStart).count();
+}
+
+void Profiler::beginFrame() {
+	double time = now();
+
+	// The frame that just ended is kept for the timeline, zones are reused so they don't allocate every frame
+	if (enabled && frameStart > 0.0) {
+		lastFrame.swap(zones);
+		lastFrameStart = frameStart;
+		lastFrameTime = time - frameStart;
+
+		if (captureFrames > 0) {
+			captured.insert(captured.end(), lastFrame.begin(), lastFrame.end());
+			captured.push_back({ "Frame", lastFrameStart, lastFrameTime, -1 });
+			capturedCounters.insert(capturedCounters.end(), counters.begin(), counters.end());
+
+			if (--captureFrames == 0) {
+				writeTrace(capturePath);
+				captured.clear();
+				capturedCounters.clear();
+			}
+		}
+	}
+
+	zones.clear();
+	counters.clear();
+	depth = 0;
+	frameStart = enabled ? time : 0.0;
+}
+
+int Profiler::beginZone(const char* pName) {
+	// Zones are only timed within a frame
+	if (frameStart == 0.0) return -1;
+
+	zones.push_back({ pName, now(), 0.0, depth++ });
+	return (int)zones.size() - 1;
+}
+
+void Profiler::endZone(int pZone) {
+	// A zone can outlive the frame it started in when the profiler is turned off
+	if (pZone >= (int)zones.size()) return;
+
+	zones[pZone].duration = now() - zones[pZone].start;
+	depth = zones[pZone].depth;
+}
+
+void Profiler::addCounter(const char* pName, double pValue) {
+	if (frameStart == 0.0) return;
+
+	counters.push_back({ pName, now(), pValue });
+}
+
+void Profiler::setEnabled(bool pEnabled) {
+	enabled = pEnabled;
+	if (!enabled) {
+		lastFrame.clear();
+		captured.clear();
+		capturedCounters.clear();
+		captureFrames = 0;
+	}
+}
+
+void Profiler::startCapture(int pFrames, const std::string& pPath) {
+	if (!enabled) {
+		std::cout << "[ERROR] Turn the profiler on to capture a trace." << std::endl;
+		return;
+	}
+
+	captured.clear();
+	capturedCounters.clear();
+	captureFrames = pFrames;
+	capturePath = pPath;
+}
+
+bool Profiler::isCapturing() {
+	return captureFrames > 0;
+}
+
+bool Profiler::writeTrace(const std::string& pPath) {
+	std::ofstream file(pPath);
+	if (!file) {
+		std::cout << "[ERROR] Failed to write trace " << pPath << std::endl;
+		return false;
+	}
+
+	// Complete events ("X") with their start and duration, frames get their own row.
+	// Counters ("C") are drawn as graphs above the rows.
+	file << "{\"traceEvents\":[\n";
+	char line[256];
+	size_t count = captured.size() + capturedCounters.size();
+	size_t written = 0;
+	for (const ProfileZone& zone : captured) {
+		snprintf(line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}%s\n",
+			zone.name, zone.start, zone.duration, zone.depth < 0 ? 0 : 1, ++written < count ? "," : "");
+		file << line;
+	}
+	for (const ProfileCounter& counter : capturedCounters) {
+		snprintf(line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"ms\":%.4f}}%s\n",
+			counter.name, counter.time, counter.value, ++written < count ? "," : "");
+		file << line;
+	}
+	file << "],\"displayTimeUnit\":\"ms\"}";
+
+	std::cout << "Trace written to " << pPath << " (" << captured.size() << " zones, " << capturedCounters.size() << " counters)" << std::endl;
+	return true;
+}
+
+const std::vector<ProfileZone>& Profiler::getLastFrame() {
+	return lastFrame;
+}
+
+double Profiler::getLastFrameTime() {
+	return lastFrameTime;
+}
+
+void Profiler::drawTimeline() {
+	if (!enabled || lastFrameTime <= 0.0) return;
+
+	int rows = 1;
+	for (const ProfileZone& zone : lastFrame) {
+		rows = std::max(rows, zone.depth + 1);
+	}
+
+	// Zones are laid out over the whole frame, nested zones go below their parent
+	const float rowHeight = 16.0f;
+	float width = ImGui::GetContentRegionAvailWidth();
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	ImGui::InvisibleButton("timeline", ImVec2(width, rows * rowHeight));
+	bool hovered = ImGui::IsItemHovered();
+
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	drawList->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + rows * rowHeight), IM_COL32(30, 30, 30, 255));
+
+	const ProfileZone* hoveredZone = nullptr;
+	for (const ProfileZone& zone : lastFrame) {
+		float x0 = origin.x + (float)((zone.start - lastFrameStart) / lastFrameTime) * width;
+		float x1 = std::max(x0 + 1.0f, origin.x + (float)((zone.start + zone.duration - lastFrameStart) / lastFrameTime) * width);
+		float y0 = origin.y + zone.depth * rowHeight;
+		ImVec2 topLeft(x0, y0);
+		ImVec2 bottomRight(x1, y0 + rowHeight - 1.0f);
+
+		// Colour by name, so a zone keeps its colour from frame to frame
+		unsigned int hash = 2166136261u;
+		for (const char* c = zone.name; *c; c++) hash = (hash ^ (unsigned char)*c) * 16777619u;
+		ImU32 colour = IM_COL32(80 + hash % 120, 80 + (hash >> 8) % 120, 80 + (hash >> 16) % 120, 255);
+
+		drawList->AddRectFilled(topLeft, bottomRight, colour);
+		drawList->PushClipRect(topLeft, bottomRight, true);
+		drawList->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32(255, 255, 255, 255), zone.name);
+		drawList->PopClipRect();
+
+		if (hovered && ImGui::IsMouseHoveringRect(topLeft, bottomRight)) hoveredZone = &zone;
+	}
+
+	if (hoveredZone) ImGui::SetTooltip("%s: %.3f ms", hoveredZone->name, hoveredZone->duration / 1000.0);
+
+	// The same zones as text, indented by depth
+	for (const ProfileZone& zone : lastFrame) {
+		ImGui::Text("%*s%s %.3f ms", zone.depth * 2, "", zone.name, zone.duration / 1000.0);
+	}
+}
\ No newline at end of file
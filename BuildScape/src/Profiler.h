@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// One timed zone of a frame, in microseconds since the profiler started
+struct ProfileZone {
+	const char* name;
+	double start;
+	double duration;
+	int depth;
+};
+
+// A value reported during a frame, like a GPU time that came back from an earlier frame
+struct ProfileCounter {
+	const char* name;
+	double time;
+	double value;
+};
+
+// Hierarchical CPU timings of the main thread, one frame at a time.
+// Zones nest by scope, the last finished frame is shown as a timeline in the debug window,
+// and a capture of several frames can be written as a Chrome trace (chrome://tracing or ui.perfetto.dev).
+// When disabled, a zone costs a single branch.
+class Profiler {
+public:
+	Profiler() = delete;
+
+	static void beginFrame();
+	static int beginZone(const char* pName);
+	static void endZone(int pZone);
+	static void addCounter(const char* pName, double pValue);
+
+	static void setEnabled(bool pEnabled);
+	static bool isEnabled() { return enabled; }
+
+	static void startCapture(int pFrames, const std::string& pPath);
+	static bool isCapturing();
+	static bool writeTrace(const std::string& pPath);
+
+	static const std::vector<ProfileZone>& getLastFrame();
+	static double getLastFrameTime();
+	static void drawTimeline();
+
+private:
+	static double now();
+
+	static bool enabled;
+	static std::vector<ProfileZone> zones;
+	static std::vector<ProfileZone> lastFrame;
+	static double frameStart;
+	static double lastFrameStart;
+	static double lastFrameTime;
+	static int depth;
+
+	// Frames that are kept for the trace
+	static std::vector<ProfileZone> captured;
+	static std::vector<ProfileCounter> counters;
+	static std::vector<ProfileCounter> capturedCounters;
+	static int captureFrames;
+	static std::string capturePath;
+};
+
+// Times the rest of the scope it's declared in
+class ProfileScope {
+public:
+	ProfileScope(const char* pName)
+		: zone(Profiler::isEnabled() ? Profiler::beginZone(pName) : -1) {}
+	~ProfileScope() {
+		if (zone >= 0) Profiler::endZone(zone);
+	}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	int zone;
+};
+
+#define PROFILE_JOIN(a, b) a##b
+#define PROFILE_NAME(a, b) PROFILE_JOIN(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_NAME(profileScope, __LINE__)(name)
\ No newline at end of file
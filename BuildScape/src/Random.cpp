@@ -3,6 +3,10 @@
 std::random_device Random::rd;
 std::mt19937 Random::gen(rd());
 
+void Random::seed(unsigned int pSeed) {
+	gen.seed(pSeed);
+}
+
 int Random::range(int pMin, int pMax) {
 	std::uniform_int_distribution<> num(pMin, pMax);
 	return (int)num(gen);
@@ -6,6 +6,7 @@ class Random {
 public:
 	Random() = delete;
 
+	static void seed(unsigned int pSeed);
 	static int range(int pMin, int pMax);
 
 private:
@@ -0,0 +1,103 @@
+#include "Raycast.h"
+
+#include <cfloat>
+#include <cmath>
+
+static int getMinAxis(glm::vec3 pValues) {
+	if (pValues.x < pValues.y) return pValues.x < pValues.z ? 0 : 2;
+	return pValues.y < pValues.z ? 1 : 2;
+}
+
+bool Raycast::cast(World& pWorld, glm::vec3 pOrigin, glm::vec3 pDirection, float pMaxDistance, RaycastHit& pHit) {
+	pHit.hit = false;
+	pHit.voxel = glm::ivec3(0);
+	pHit.normal = glm::ivec3(0);
+	pHit.distance = pMaxDistance;
+	pHit.id = 0;
+
+	float length = glm::length(pDirection);
+	if (length == 0.0f) return false;
+	glm::vec3 direction = pDirection / length;
+
+	// Work in voxel units, where voxel v covers [v, v + 1)
+	float voxelSize = pWorld.getVoxelSize();
+	glm::vec3 origin = pOrigin / voxelSize + 0.5f;
+	float maxT = pMaxDistance / voxelSize;
+
+	glm::ivec3 voxel = glm::ivec3(glm::floor(origin));
+	glm::ivec3 step;
+	glm::vec3 tDelta;
+	glm::vec3 tMax;
+	for (int i = 0; i < 3; i++) {
+		step[i] = direction[i] > 0.0f ? 1 : (direction[i] < 0.0f ? -1 : 0);
+		tDelta[i] = step[i] != 0 ? 1.0f / std::fabs(direction[i]) : FLT_MAX;
+		tMax[i] = step[i] != 0 ? ((float)(voxel[i] + (step[i] > 0 ? 1 : 0)) - origin[i]) / direction[i] : FLT_MAX;
+	}
+
+	glm::ivec3 dimensions = World::getChunkDimensions();
+	glm::ivec3 normal(0);
+	float t = 0.0f;
+
+	while (t <= maxT) {
+		glm::ivec3 coordinates = World::getVoxelChunkCoordinates(voxel);
+		glm::ivec3 chunkMin = coordinates * dimensions;
+		glm::ivec3 chunkMax = chunkMin + dimensions;
+		Chunk* chunk = pWorld.getChunk(coordinates.x, coordinates.y, coordinates.z);
+
+		if (!chunk || chunk->isEmpty()) {
+			// Jump to where the ray leaves the chunk
+			glm::vec3 tExit;
+			for (int i = 0; i < 3; i++) {
+				tExit[i] = step[i] != 0 ? ((float)(step[i] > 0 ? chunkMax[i] : chunkMin[i]) - origin[i]) / direction[i] : FLT_MAX;
+			}
+
+			int axis = getMinAxis(tExit);
+			t = tExit[axis];
+			for (int i = 0; i < 3; i++) {
+				if (i == axis) voxel[i] = step[i] > 0 ? chunkMax[i] : chunkMin[i] - 1;
+				else voxel[i] = glm::clamp((int)std::floor(origin[i] + direction[i] * t), chunkMin[i], chunkMax[i] - 1);
+
+				if (step[i] != 0) tMax[i] = ((float)(voxel[i] + (step[i] > 0 ? 1 : 0)) - origin[i]) / direction[i];
+			}
+
+			normal = glm::ivec3(0);
+			normal[axis] = -step[axis];
+			continue;
+		}
+
+		// Step through the chunk's blocks until the ray leaves it
+		std::vector<std::uint32_t>& blocks = chunk->getBlocks();
+		glm::ivec3 local = voxel - chunkMin;
+		while (t <= maxT) {
+			int id = (blocks[Chunk::getIndex(local.x, local.y, local.z)] >> 12) & 0xFF;
+			if (id != 0) {
+				pHit.hit = true;
+				pHit.voxel = voxel;
+				pHit.normal = normal;
+				pHit.distance = t * voxelSize;
+				pHit.id = (std::uint8_t)id;
+				return true;
+			}
+
+			int axis = getMinAxis(tMax);
+			t = tMax[axis];
+			tMax[axis] += tDelta[axis];
+			voxel[axis] += step[axis];
+			local[axis] += step[axis];
+			normal = glm::ivec3(0);
+			normal[axis] = -step[axis];
+
+			if (local[axis] < 0 || local[axis] >= dimensions[axis]) break;
+		}
+	}
+
+	return false;
+}
+
+int Raycast::castBatch(World& pWorld, const glm::vec3* pOrigins, const glm::vec3* pDirections, int pCount, float pMaxDistance, RaycastHit* pHits) {
+	int hits = 0;
+	for (int i = 0; i < pCount; i++) {
+		if (cast(pWorld, pOrigins[i], pDirections[i], pMaxDistance, pHits[i])) hits++;
+	}
+	return hits;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+#include "World.h"
+
+struct RaycastHit {
+	bool hit;
+	glm::ivec3 voxel;
+	// Points out of the face the ray entered through, zero when the ray starts inside the voxel
+	glm::ivec3 normal;
+	float distance;
+	std::uint8_t id;
+};
+
+// Voxel traversal after Amanatides and Woo. Rays walk through loaded chunks voxel by voxel
+// and skip chunks that aren't loaded or are empty in a single step.
+class Raycast {
+public:
+	Raycast() = delete;
+
+	static bool cast(World& pWorld, glm::vec3 pOrigin, glm::vec3 pDirection, float pMaxDistance, RaycastHit& pHit);
+	static int castBatch(World& pWorld, const glm::vec3* pOrigins, const glm::vec3* pDirections, int pCount, float pMaxDistance, RaycastHit* pHits);
+};
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "RegionFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#include <share.h>
+#else
+#include <unistd.h>
+#endif
+
+static const char regionMagic[4] = { 'B', 'S', 'R', 'G' };
+static const std::uint32_t regionVersion = 1;
+
+// The file is shared so it can be mapped while it's open for writing
+static FILE* openFile(const std::string& pPath, const char* pMode) {
+#ifdef _WIN32
+	return _fsopen(pPath.c_str(), pMode, _SH_DENYNO);
+#else
+	return fopen(pPath.c_str(), pMode);
+#endif
+}
+
+// Region files easily grow past 2 GB, so always seek with 64 bit offsets
+static int seekFile(FILE* pFile, long long pOffset, int pOrigin) {
+#ifdef _WIN32
+	return _fseeki64(pFile, pOffset, pOrigin);
+#else
+	return fseeko(pFile, pOffset, pOrigin);
+#endif
+}
+
+static long long tellFile(FILE* pFile) {
+#ifdef _WIN32
+	return _ftelli64(pFile);
+#else
+	return ftello(pFile);
+#endif
+}
+
+RegionFile::RegionFile(const std::string& pPath)
+	: path(pPath), file(nullptr), headerSlot(0), changed(false)
+{
+	memset(&header, 0, sizeof(header));
+	memset(&committedHeader, 0, sizeof(committedHeader));
+}
+
+RegionFile::~RegionFile() {
+	close();
+}
+
+bool RegionFile::open(bool pCreate) {
+	if (file) return true;
+
+	file = openFile(path, "r+b");
+	if (file) {
+		// Use whichever header slot is valid and most recent
+		Header slots[2];
+		bool valid[2] = { readHeader(0, slots[0]), readHeader(1, slots[1]) };
+		if (!valid[0] && !valid[1]) {
+			std::cout << "[ERROR] Region file " << path << " has no valid header." << std::endl;
+			close();
+			return false;
+		}
+
+		headerSlot = (valid[0] && (!valid[1] || slots[0].sequence > slots[1].sequence)) ? 0 : 1;
+		header = slots[headerSlot];
+		committedHeader = header;
+		return true;
+	}
+
+	if (!pCreate) return false;
+
+	// Create a new region with an empty offset table
+	file = openFile(path, "w+b");
+	if (!file) {
+		std::cout << "[ERROR] Could not create region file " << path << "." << std::endl;
+		return false;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, regionMagic, sizeof(regionMagic));
+	header.version = regionVersion;
+
+	// Reserve both header slots so payloads are always appended after them
+	headerSlot = 1;
+	std::vector<std::uint8_t> empty(HEADER_SECTORS * 2 * SECTOR_SIZE, 0);
+	fwrite(empty.data(), 1, empty.size(), file);
+	return writeHeader(0);
+}
+
+void RegionFile::close() {
+	if (!file) return;
+
+	if (changed) commit();
+	mappedFile.close();
+	fclose(file);
+	file = nullptr;
+}
+
+bool RegionFile::isOpen() {
+	return file != nullptr;
+}
+
+bool RegionFile::hasChunk(int pX, int pZ) {
+	return header.entries[pZ * SIZE + pX].length > 0;
+}
+
+bool RegionFile::readChunk(int pX, int pZ, std::vector<std::uint8_t>& pData) {
+	const Entry& entry = header.entries[pZ * SIZE + pX];
+	if (!file || entry.length == 0) return false;
+
+	pData.resize(entry.length);
+	if (seekFile(file, (long long)entry.offset * SECTOR_SIZE, SEEK_SET) != 0) return false;
+	return fread(pData.data(), 1, entry.length, file) == entry.length;
+}
+
+const std::uint8_t* RegionFile::mapChunk(int pX, int pZ, size_t& pLength) {
+	const Entry& entry = header.entries[pZ * SIZE + pX];
+	if (!file || entry.length == 0 || !isMapped(entry)) return nullptr;
+
+	// Decoding straight from the mapping saves copying the payload into a buffer first
+	pLength = entry.length;
+	return mappedFile.getData() + (size_t)entry.offset * SECTOR_SIZE;
+}
+
+void RegionFile::prefetchChunk(int pX, int pZ) {
+	const Entry& entry = header.entries[pZ * SIZE + pX];
+	if (!file || entry.length == 0 || !isMapped(entry)) return;
+
+	mappedFile.prefetch((size_t)entry.offset * SECTOR_SIZE, entry.length);
+}
+
+bool RegionFile::writeChunk(int pX, int pZ, const std::vector<std::uint8_t>& pData) {
+	if (!file || pData.empty()) return false;
+
+	// Write the payload to free sectors, never overwriting data the committed header still points at
+	int index = pZ * SIZE + pX;
+	std::uint32_t sector = findFreeSector(index, (std::uint32_t)((pData.size() + SECTOR_SIZE - 1) / SECTOR_SIZE));
+	seekFile(file, 0, SEEK_END);
+	long long end = tellFile(file);
+	if ((long long)sector * SECTOR_SIZE > end) {
+		std::vector<std::uint8_t> padding((size_t)((long long)sector * SECTOR_SIZE - end), 0);
+		fwrite(padding.data(), 1, padding.size(), file);
+	}
+	else {
+		seekFile(file, (long long)sector * SECTOR_SIZE, SEEK_SET);
+	}
+
+	if (fwrite(pData.data(), 1, pData.size(), file) != pData.size()) {
+		std::cout << "[ERROR] Writing to region file " << path << " failed." << std::endl;
+		return false;
+	}
+
+	// Reused sectors can be inside the mapping, which only sees the data once it left the stdio buffer
+	fflush(file);
+
+	// The new location only becomes visible once the header is committed
+	Entry& entry = header.entries[index];
+	entry.offset = sector;
+	entry.length = (std::uint32_t)pData.size();
+	changed = true;
+	return true;
+}
+
+bool RegionFile::commit() {
+	if (!file || !changed) return true;
+
+	// Payloads have to be on disk before a header can point at them
+	flush();
+	if (!writeHeader(1 - headerSlot)) return false;
+	changed = false;
+	return true;
+}
+
+std::uint32_t RegionFile::calculateChecksum(const Header& pHeader) {
+	// FNV-1a over the sequence number and offset table
+	std::uint32_t hash = 2166136261u;
+	const std::uint8_t* bytes = (const std::uint8_t*)&pHeader.sequence;
+	for (size_t i = 0; i < sizeof(pHeader.sequence); i++) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+
+	bytes = (const std::uint8_t*)pHeader.entries;
+	for (size_t i = 0; i < sizeof(pHeader.entries); i++) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+bool RegionFile::readHeader(int pSlot, Header& pHeader) {
+	if (seekFile(file, (long long)pSlot * HEADER_SECTORS * SECTOR_SIZE, SEEK_SET) != 0) return false;
+	if (fread(&pHeader, sizeof(Header), 1, file) != 1) return false;
+
+	return memcmp(pHeader.magic, regionMagic, sizeof(regionMagic)) == 0 &&
+		pHeader.version == regionVersion && pHeader.checksum == calculateChecksum(pHeader);
+}
+
+bool RegionFile::writeHeader(int pSlot) {
+	header.sequence++;
+	header.checksum = calculateChecksum(header);
+
+	seekFile(file, (long long)pSlot * HEADER_SECTORS * SECTOR_SIZE, SEEK_SET);
+	if (fwrite(&header, sizeof(Header), 1, file) != 1) {
+		std::cout << "[ERROR] Writing the header of region file " << path << " failed." << std::endl;
+		return false;
+	}
+
+	flush();
+	headerSlot = pSlot;
+	committedHeader = header;
+	return true;
+}
+
+std::uint32_t RegionFile::findFreeSector(int pIndex, std::uint32_t pSectors) {
+	// Sectors in use by the committed header or by other chunks written since then, as [first, last) ranges.
+	// The chunk that is being written can reuse its own uncommitted sectors, no header on disk points at them.
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> used;
+	used.reserve(SIZE * SIZE * 2);
+	for (int i = 0; i < SIZE * SIZE; i++) {
+		const Entry& committed = committedHeader.entries[i];
+		if (committed.length > 0) used.push_back(std::make_pair(committed.offset, committed.offset + (committed.length + SECTOR_SIZE - 1) / SECTOR_SIZE));
+
+		const Entry& entry = header.entries[i];
+		if (i != pIndex && entry.length > 0) used.push_back(std::make_pair(entry.offset, entry.offset + (entry.length + SECTOR_SIZE - 1) / SECTOR_SIZE));
+	}
+	std::sort(used.begin(), used.end());
+
+	// First gap after the header slots that is large enough, or else after the last payload
+	std::uint32_t sector = HEADER_SECTORS * 2;
+	for (const auto& range : used) {
+		if (range.first >= sector + pSectors) return sector;
+		sector = std::max(sector, range.second);
+	}
+	return sector;
+}
+
+bool RegionFile::isMapped(const Entry& pEntry) {
+	size_t end = (size_t)pEntry.offset * SECTOR_SIZE + pEntry.length;
+	if (mappedFile.isOpen() && end <= mappedFile.getSize()) return true;
+
+	// Anything past the mapping was written after it was made
+	return mappedFile.open(path) && end <= mappedFile.getSize();
+}
+
+void RegionFile::flush() {
+	fflush(file);
+#ifdef _WIN32
+	_commit(_fileno(file));
+#else
+	fsync(fileno(file));
+#endif
+}
\ No newline at end of file
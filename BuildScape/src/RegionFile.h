@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+// A region holds 32x32 chunks of one chunk layer in a single file.
+//
+// The file starts with two header slots, each holding an offset table with an entry for every chunk.
+// Chunk payloads are never written over sectors that the last committed header still points at, and the
+// header is then written to the slot that isn't in use. A crash halfway through a save therefore always
+// leaves one valid header behind, pointing at payloads that were completely written. Sectors of payloads
+// that were replaced are reused once a commit no longer points at them, so resaving chunks doesn't keep
+// growing the file.
+class RegionFile {
+public:
+	static const int SIZE = 32;
+	static const int SECTOR_SIZE = 4096;
+
+	RegionFile(const std::string& pPath);
+	~RegionFile();
+
+	bool open(bool pCreate);
+	void close();
+	bool isOpen();
+
+	bool hasChunk(int pX, int pZ);
+	bool readChunk(int pX, int pZ, std::vector<std::uint8_t>& pData);
+	const std::uint8_t* mapChunk(int pX, int pZ, size_t& pLength);
+	void prefetchChunk(int pX, int pZ);
+	bool writeChunk(int pX, int pZ, const std::vector<std::uint8_t>& pData);
+	bool commit();
+
+private:
+	struct Entry {
+		std::uint32_t offset;
+		std::uint32_t length;
+	};
+
+	struct Header {
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t sequence;
+		std::uint32_t checksum;
+		Entry entries[SIZE * SIZE];
+	};
+
+	static const int HEADER_SECTORS = (sizeof(Header) + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+	std::string path;
+	FILE* file;
+	MappedFile mappedFile;
+	Header header;
+	Header committedHeader;
+	int headerSlot;
+	bool changed;
+
+	std::uint32_t calculateChecksum(const Header& pHeader);
+	bool readHeader(int pSlot, Header& pHeader);
+	bool writeHeader(int pSlot);
+	std::uint32_t findFreeSector(int pIndex, std::uint32_t pSectors);
+	bool isMapped(const Entry& pEntry);
+	void flush();
+};
\ No newline at end of file
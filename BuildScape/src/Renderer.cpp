@@ -1,7 +1,7 @@
 #include "Renderer.h"
 
 Renderer::Renderer()
-	: VAO(0), VBO(0), EBO(0), window(nullptr) {
+	: window(nullptr) {
 
 }
 
@@ -9,7 +9,7 @@ Renderer::~Renderer() {
 	
 }
 
-int Renderer::initialize(int pWindowWidth, int pWindowHeight, std::string(pWindowName), const float pCubeVertices[], int pNumVertices) {
+int Renderer::initialize(int pWindowWidth, int pWindowHeight, std::string(pWindowName)) {
 	// Initialize GLFW
 	if (!glfwInit())
 		return -1;
@@ -42,20 +42,6 @@ int Renderer::initialize(int pWindowWidth, int pWindowHeight, std::string(pWindo
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LESS);
 
-	// Generate buffers
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
-
-	// Bind the voxel vertex array
-	glBindVertexArray(VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, pNumVertices * sizeof(float), pCubeVertices, GL_STATIC_DRAW);
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
 	return 0;
 }
 
@@ -63,29 +49,51 @@ GLFWwindow* Renderer::getWindow() {
 	return window;
 }
 
-void Renderer::bindEBO() {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-}
-
-void Renderer::unbindEBO() {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-}
-
 GLuint Renderer::setShader(const char* pShaderSource, GLenum pType) {
 	GLuint shader = glCreateShader(pType);
 	glShaderSource(shader, 1, &pShaderSource, nullptr);
 	glCompileShader(shader);
+
+	GLint compiled;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	if (!compiled) {
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+		std::cout << "[ERROR] Compiling " << (pType == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader failed:\n" << log << std::endl;
+		glDeleteShader(shader);
+		return 0;
+	}
+
 	return shader;
 }
 
 GLuint Renderer::createShaderProgram(GLuint pVertexShader, GLuint pFragmentShader) {
+	if (!pVertexShader || !pFragmentShader) {
+		if (pVertexShader) glDeleteShader(pVertexShader);
+		if (pFragmentShader) glDeleteShader(pFragmentShader);
+		return 0;
+	}
+
 	GLuint shaderProgram = glCreateProgram();
 	glAttachShader(shaderProgram, pVertexShader);
 	glAttachShader(shaderProgram, pFragmentShader);
+
+	// Programs can be saved to skip compiling them next time
+	if (GLEW_ARB_get_program_binary) glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(shaderProgram);
 
 	glDeleteShader(pVertexShader);
 	glDeleteShader(pFragmentShader);
 
+	GLint linked;
+	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		char log[1024];
+		glGetProgramInfoLog(shaderProgram, sizeof(log), nullptr, log);
+		std::cout << "[ERROR] Linking shader program failed:\n" << log << std::endl;
+		glDeleteProgram(shaderProgram);
+		return 0;
+	}
+
 	return shaderProgram;
 }
\ No newline at end of file
@@ -10,18 +10,12 @@ public:
 	Renderer();
 	~Renderer();
 
-	int initialize(int pWindowWidth, int pWindowHeight, std::string(pWindowName), const float pCubeVertices[], int pNumVertices);
+	int initialize(int pWindowWidth, int pWindowHeight, std::string(pWindowName));
 	GLFWwindow* getWindow();
-	void bindEBO();
-	void unbindEBO();
 
 	GLuint setShader(const char* pShaderSource, GLenum pType);
 	GLuint createShaderProgram(GLuint pVertexShader, GLuint pFragmentShader);
 
 private:
-	GLuint VAO;
-	GLuint VBO;
-	GLuint EBO;
-
 	GLFWwindow* window;
 };
\ No newline at end of file
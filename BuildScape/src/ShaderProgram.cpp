@@ -0,0 +1,223 @@
+#include "ShaderProgram.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "GLFW/glfw3.h"
+
+#include "Renderer.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+#include <sys/stat.h>
+
+static const char binaryMagic[4] = { 'B', 'S', 'S', 'H' };
+
+// Files are checked for changes at most this often
+static const double reloadInterval = 0.5;
+
+std::string ShaderProgram::cacheDirectory;
+
+static bool readFile(const std::string& pPath, std::string& pText) {
+	std::ifstream file(pPath, std::ios::binary);
+	if (!file) {
+		std::cout << "[ERROR] Failed to read shader file " << pPath << std::endl;
+		return false;
+	}
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	pText = stream.str();
+	return true;
+}
+
+static long long getModifiedTime(const std::string& pPath) {
+#ifdef _WIN32
+	struct _stat fileStat;
+	if (_stat(pPath.c_str(), &fileStat) != 0) return 0;
+#else
+	struct stat fileStat;
+	if (stat(pPath.c_str(), &fileStat) != 0) return 0;
+#endif
+	return (long long)fileStat.st_mtime;
+}
+
+// FNV-1a, continued from the previous hash
+static std::uint64_t hashString(std::uint64_t pHash, const char* pText) {
+	if (!pText) return pHash;
+	for (const char* c = pText; *c; c++) {
+		pHash = (pHash ^ (std::uint8_t)*c) * 1099511628211ull;
+	}
+
+	// Separate the strings, so moving text from one to the next changes the hash
+	return (pHash ^ 0xFF) * 1099511628211ull;
+}
+
+ShaderProgram::ShaderProgram(Renderer* pRenderer, const std::string& pVertexPath, const std::string& pFragmentPath)
+	: renderer(pRenderer), vertexPath(pVertexPath), fragmentPath(pFragmentPath), program(0), cached(false), loadTime(0.0),
+	vertexTime(0), fragmentTime(0), lastCheck(0.0)
+{
+
+}
+
+ShaderProgram::~ShaderProgram() {
+	destroy();
+}
+
+bool ShaderProgram::load() {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::string vertexSource, fragmentSource;
+	if (!readSources(vertexSource, fragmentSource)) return false;
+
+	// A different driver can't load the binary, so it's part of the key
+	std::uint64_t hash = 14695981039346656037ull;
+	hash = hashString(hash, vertexSource.c_str());
+	hash = hashString(hash, fragmentSource.c_str());
+	hash = hashString(hash, (const char*)glGetString(GL_VENDOR));
+	hash = hashString(hash, (const char*)glGetString(GL_RENDERER));
+	hash = hashString(hash, (const char*)glGetString(GL_VERSION));
+
+	GLuint newProgram = loadBinary(hash);
+	bool fromCache = newProgram != 0;
+	if (!newProgram) {
+		GLuint vertexShader = renderer->setShader(vertexSource.c_str(), GL_VERTEX_SHADER);
+		GLuint fragmentShader = renderer->setShader(fragmentSource.c_str(), GL_FRAGMENT_SHADER);
+		newProgram = renderer->createShaderProgram(vertexShader, fragmentShader);
+		if (!newProgram) {
+			std::cout << "[ERROR] Shader " << vertexPath << " and " << fragmentPath << " failed, " << (program ? "keeping the old program" : "nothing to draw with") << std::endl;
+			return false;
+		}
+		saveBinary(newProgram, hash);
+	}
+
+	if (program) glDeleteProgram(program);
+	program = newProgram;
+	cached = fromCache;
+	loadTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() * 1000.0;
+
+	std::cout << "Shader " << vertexPath << " and " << fragmentPath << (cached ? " loaded from cache in " : " compiled in ") << loadTime << " ms\n";
+	return true;
+}
+
+bool ShaderProgram::reloadIfChanged() {
+	double time = glfwGetTime();
+	if (time - lastCheck < reloadInterval) return false;
+	lastCheck = time;
+
+	if (getModifiedTime(vertexPath) == vertexTime && getModifiedTime(fragmentPath) == fragmentTime) return false;
+
+	std::cout << "Reloading shader " << vertexPath << " and " << fragmentPath << std::endl;
+	return load();
+}
+
+void ShaderProgram::destroy() {
+	if (!program) return;
+
+	glDeleteProgram(program);
+	program = 0;
+}
+
+GLuint ShaderProgram::getProgram() {
+	return program;
+}
+
+bool ShaderProgram::isCached() {
+	return cached;
+}
+
+double ShaderProgram::getLoadTime() {
+	return loadTime;
+}
+
+void ShaderProgram::setCacheDirectory(const std::string& pDirectory) {
+	cacheDirectory = pDirectory;
+
+#ifdef _WIN32
+	_mkdir(cacheDirectory.c_str());
+#else
+	mkdir(cacheDirectory.c_str(), 0755);
+#endif
+}
+
+bool ShaderProgram::readSources(std::string& pVertexSource, std::string& pFragmentSource) {
+	// Remember the times first, so a broken file isn't read again until it changes
+	vertexTime = getModifiedTime(vertexPath);
+	fragmentTime = getModifiedTime(fragmentPath);
+
+	return readFile(vertexPath, pVertexSource) && readFile(fragmentPath, pFragmentSource);
+}
+
+GLuint ShaderProgram::loadBinary(std::uint64_t pHash) {
+	if (cacheDirectory.empty() || !GLEW_ARB_get_program_binary) return 0;
+
+	std::ifstream file(getCachePath(pHash), std::ios::binary);
+	if (!file) return 0;
+
+	char magic[4];
+	std::uint64_t hash = 0;
+	GLenum format = 0;
+	std::uint32_t size = 0;
+	file.read(magic, sizeof(magic));
+	file.read((char*)&hash, sizeof(hash));
+	file.read((char*)&format, sizeof(format));
+	file.read((char*)&size, sizeof(size));
+	if (!file || std::memcmp(magic, binaryMagic, sizeof(magic)) != 0 || hash != pHash || size == 0) return 0;
+
+	std::vector<char> binary(size);
+	if (!file.read(binary.data(), size)) return 0;
+
+	// Drivers can refuse binaries they made themselves, after an update for example
+	GLuint binaryProgram = glCreateProgram();
+	glProgramBinary(binaryProgram, format, binary.data(), (GLsizei)size);
+
+	GLint linked;
+	glGetProgramiv(binaryProgram, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		glDeleteProgram(binaryProgram);
+		return 0;
+	}
+
+	return binaryProgram;
+}
+
+void ShaderProgram::saveBinary(GLuint pProgram, std::uint64_t pHash) {
+	if (cacheDirectory.empty() || !GLEW_ARB_get_program_binary) return;
+
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	GLint length = 0;
+	glGetProgramiv(pProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (formats == 0 || length <= 0) return;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	GLsizei written = 0;
+	glGetProgramBinary(pProgram, length, &written, &format, binary.data());
+	if (written <= 0) return;
+
+	std::ofstream file(getCachePath(pHash), std::ios::binary);
+	if (!file) {
+		std::cout << "[ERROR] Failed to write the shader cache in " << cacheDirectory << std::endl;
+		return;
+	}
+
+	std::uint32_t size = (std::uint32_t)written;
+	file.write(binaryMagic, sizeof(binaryMagic));
+	file.write((const char*)&pHash, sizeof(pHash));
+	file.write((const char*)&format, sizeof(format));
+	file.write((const char*)&size, sizeof(size));
+	file.write(binary.data(), size);
+}
+
+std::string ShaderProgram::getCachePath(std::uint64_t pHash) {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)pHash);
+	return cacheDirectory + "/" + name;
+}
\ No newline at end of file
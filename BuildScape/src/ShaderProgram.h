@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "GL/glew.h"
+
+class Renderer;
+
+// Shader program read from a vertex and a fragment shader file.
+// Linked programs are saved in the cache directory, keyed by a hash of the sources and the driver,
+// so later startups load the binary instead of compiling. The files are watched and reloaded when they change,
+// a reload that doesn't compile keeps the old program.
+class ShaderProgram {
+public:
+	ShaderProgram(Renderer* pRenderer, const std::string& pVertexPath, const std::string& pFragmentPath);
+	~ShaderProgram();
+	ShaderProgram(const ShaderProgram&) = delete;
+	ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+	bool load();
+	bool reloadIfChanged();
+	void destroy();
+
+	GLuint getProgram();
+	bool isCached();
+	double getLoadTime();
+
+	static void setCacheDirectory(const std::string& pDirectory);
+
+private:
+	bool readSources(std::string& pVertexSource, std::string& pFragmentSource);
+	GLuint loadBinary(std::uint64_t pHash);
+	void saveBinary(GLuint pProgram, std::uint64_t pHash);
+	std::string getCachePath(std::uint64_t pHash);
+
+	Renderer* renderer;
+	std::string vertexPath;
+	std::string fragmentPath;
+
+	GLuint program;
+	bool cached;
+	double loadTime;
+
+	// Modification times of the files when they were last read
+	long long vertexTime;
+	long long fragmentTime;
+	double lastCheck;
+
+	static std::string cacheDirectory;
+};
\ No newline at end of file
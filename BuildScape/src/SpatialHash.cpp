@@ -0,0 +1,146 @@
+#include "SpatialHash.h"
+
+#include <algorithm>
+#include <iostream>
+
+SpatialHash::SpatialHash(World* pWorld, int pCellSize)
+	: cellSize(pCellSize), voxelSize(pWorld->getVoxelSize()), count(0)
+{
+	// Cells have to divide chunks evenly
+	glm::ivec3 dimensions = World::getChunkDimensions();
+	if (cellSize <= 0 || dimensions.x % cellSize != 0 || dimensions.y % cellSize != 0 || dimensions.z % cellSize != 0) {
+		std::cout << "[ERROR] Cell size " << cellSize << " doesn't divide the chunks, using the chunk size instead." << std::endl;
+		cellSize = std::min(dimensions.x, std::min(dimensions.y, dimensions.z));
+	}
+}
+
+SpatialHash::~SpatialHash() {
+
+}
+
+void SpatialHash::insert(int pId, glm::vec3 pPosition) {
+	if (pId >= (int)positions.size()) {
+		positions.resize(pId + 1);
+		entityCells.resize(pId + 1, -1);
+		slots.resize(pId + 1, -1);
+	}
+	if (slots[pId] >= 0) removeFromCell(pId);
+
+	glm::ivec3 cell = getCell(pPosition);
+	positions[pId] = pPosition;
+	addToCell(pId, cell, World::getChunkKey(cell.x, cell.y, cell.z));
+	count++;
+}
+
+void SpatialHash::move(int pId, glm::vec3 pPosition) {
+	positions[pId] = pPosition;
+
+	// Most moves stay within the same cell
+	glm::ivec3 cell = getCell(pPosition);
+	std::int64_t key = World::getChunkKey(cell.x, cell.y, cell.z);
+	if (key == entityCells[pId]) return;
+
+	removeFromCell(pId);
+	addToCell(pId, cell, key);
+}
+
+void SpatialHash::remove(int pId) {
+	if (pId >= (int)slots.size() || slots[pId] < 0) return;
+
+	removeFromCell(pId);
+	count--;
+}
+
+void SpatialHash::clear() {
+	cells.clear();
+	positions.clear();
+	entityCells.clear();
+	slots.clear();
+	count = 0;
+}
+
+void SpatialHash::addToCell(int pId, glm::ivec3 pCell, std::int64_t pKey) {
+	SpatialCell& cell = cells[pKey];
+	cell.coordinates = pCell;
+
+	std::vector<int>& ids = cell.ids;
+	entityCells[pId] = pKey;
+	slots[pId] = (int)ids.size();
+	ids.push_back(pId);
+}
+
+void SpatialHash::removeFromCell(int pId) {
+	// The last id in the cell takes the place of the removed one
+	auto it = cells.find(entityCells[pId]);
+	std::vector<int>& ids = it->second.ids;
+	int last = ids.back();
+	ids[slots[pId]] = last;
+	slots[last] = slots[pId];
+	ids.pop_back();
+	if (ids.empty()) cells.erase(it);
+
+	entityCells[pId] = -1;
+	slots[pId] = -1;
+}
+
+void SpatialHash::queryRadius(glm::vec3 pCentre, float pRadius, std::vector<int>& pResults) {
+	glm::ivec3 minCell = getCell(pCentre - pRadius);
+	glm::ivec3 maxCell = getCell(pCentre + pRadius);
+	float radiusSquared = pRadius * pRadius;
+
+	for (int y = minCell.y; y <= maxCell.y; y++) {
+		for (int z = minCell.z; z <= maxCell.z; z++) {
+			for (int x = minCell.x; x <= maxCell.x; x++) {
+				auto it = cells.find(World::getChunkKey(x, y, z));
+				if (it == cells.end()) continue;
+
+				for (int id : it->second.ids) {
+					glm::vec3 offset = positions[id] - pCentre;
+					if (glm::dot(offset, offset) <= radiusSquared) pResults.push_back(id);
+				}
+			}
+		}
+	}
+}
+
+void SpatialHash::queryBox(glm::vec3 pMin, glm::vec3 pMax, std::vector<int>& pResults) {
+	glm::ivec3 minCell = getCell(pMin);
+	glm::ivec3 maxCell = getCell(pMax);
+
+	for (int y = minCell.y; y <= maxCell.y; y++) {
+		for (int z = minCell.z; z <= maxCell.z; z++) {
+			for (int x = minCell.x; x <= maxCell.x; x++) {
+				auto it = cells.find(World::getChunkKey(x, y, z));
+				if (it == cells.end()) continue;
+
+				for (int id : it->second.ids) {
+					glm::vec3 position = positions[id];
+					if (glm::all(glm::greaterThanEqual(position, pMin)) && glm::all(glm::lessThanEqual(position, pMax))) pResults.push_back(id);
+				}
+			}
+		}
+	}
+}
+
+int SpatialHash::getCellSize() {
+	return cellSize;
+}
+
+glm::ivec3 SpatialHash::getCell(glm::vec3 pPosition) {
+	// Voxel v is centred on v * voxelSize and covers [v - 0.5, v + 0.5) voxels
+	glm::ivec3 voxel(glm::floor(pPosition / voxelSize + 0.5f));
+	return World::floorDivide(voxel, glm::ivec3(cellSize));
+}
+
+glm::ivec3 SpatialHash::getCellChunk(glm::ivec3 pCell) {
+	glm::ivec3 cellsPerChunk = World::getChunkDimensions() / cellSize;
+	return World::floorDivide(pCell, cellsPerChunk);
+}
+
+std::unordered_map<std::int64_t, SpatialCell>& SpatialHash::getCells() {
+	return cells;
+}
+
+int SpatialHash::getCount() {
+	return count;
+}
\ No newline at end of file
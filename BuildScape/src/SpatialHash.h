@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "World.h"
+
+struct SpatialCell {
+	glm::ivec3 coordinates;
+	std::vector<int> ids;
+};
+
+// Uniform grid of cells for finding entities near a point. Cells are a whole number of voxels and
+// divide chunks evenly, so every cell lies in exactly one chunk.
+class SpatialHash {
+public:
+	SpatialHash(World* pWorld, int pCellSize);
+	~SpatialHash();
+
+	void insert(int pId, glm::vec3 pPosition);
+	void move(int pId, glm::vec3 pPosition);
+	void remove(int pId);
+	void clear();
+
+	void queryRadius(glm::vec3 pCentre, float pRadius, std::vector<int>& pResults);
+	void queryBox(glm::vec3 pMin, glm::vec3 pMax, std::vector<int>& pResults);
+
+	int getCellSize();
+	glm::ivec3 getCell(glm::vec3 pPosition);
+	glm::ivec3 getCellChunk(glm::ivec3 pCell);
+	std::unordered_map<std::int64_t, SpatialCell>& getCells();
+	int getCount();
+
+private:
+	int cellSize;
+	float voxelSize;
+
+	std::unordered_map<std::int64_t, SpatialCell> cells;
+
+	// Where every id is, indexed by id
+	std::vector<glm::vec3> positions;
+	std::vector<std::int64_t> entityCells;
+	std::vector<int> slots;
+	int count;
+
+	void addToCell(int pId, glm::ivec3 pCell, std::int64_t pKey);
+	void removeFromCell(int pId);
+};
\ No newline at end of file
@@ -1,38 +1,58 @@
 #include "World.h"
 
-// Voxel indices for each direction
-const unsigned int cubeIndicesLeft[] = {
-	4, 6, 2,
-	4, 2, 0
-};
+#include <climits>
 
-const unsigned int cubeIndicesRight[] = {
-	1, 3, 7,
-	1, 7, 5
-};
+#include "Profiler.h"
 
-const unsigned int cubeIndicesTop[] = {
-	2, 6, 7,
-	2, 7, 3
-};
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
-const unsigned int cubeIndicesBottom[] = {
-	4, 0, 1,
-	4, 1, 5
+// Corners of each face in the order of the face bits (left, right, down, up, front, back).
+// A corner's bits give its side along x (1), y (2) and z (4).
+const int faceCorners[6][4] = {
+	{ 4, 6, 2, 0 },
+	{ 1, 3, 7, 5 },
+	{ 4, 0, 1, 5 },
+	{ 2, 6, 7, 3 },
+	{ 0, 2, 3, 1 },
+	{ 4, 6, 7, 5 }
 };
 
-const unsigned int cubeIndicesFront[] = {
-	0, 2, 3,
-	0, 3, 1
+// Two triangles per face, split along either diagonal
+const unsigned int faceIndices[] = {
+	0, 1, 2,
+	0, 2, 3
+};
+const unsigned int flippedFaceIndices[] = {
+	1, 2, 3,
+	1, 3, 0
 };
 
-const unsigned int cubeIndicesBack[] = {
-	4, 6, 7,
-	4, 7, 5
+// Offset to the neighbouring block for each face
+const int faceDirections[6][3] = {
+	{ -1, 0, 0 },
+	{ 1, 0, 0 },
+	{ 0, -1, 0 },
+	{ 0, 1, 0 },
+	{ 0, 0, -1 },
+	{ 0, 0, 1 }
 };
 
+// Depth of the octree backend, which covers voxels from -32768 to 32767 along each axis
+static const int octreeDepth = 16;
+
+// How open a face corner is, from 0 to 3, given the blocks on its two sides and the one diagonally across.
+// A corner between two blocks is fully dark, as the block across can't make it any darker.
+static int getOcclusion(bool pSide1, bool pSide2, bool pCorner) {
+	if (pSide1 && pSide2) return 0;
+	return 3 - ((int)pSide1 + (int)pSide2 + (int)pCorner);
+}
+
 World::World(float pVoxelSize, int pTopLayer, Camera* pCamera, Renderer* pRenderer)
-	: voxelSize(pVoxelSize), topLayer(pTopLayer), camera(pCamera), renderer(pRenderer), shaderProgram(NULL), wireframe(0)
+	: voxelSize(pVoxelSize), topLayer(pTopLayer), camera(pCamera), renderer(pRenderer), shaderProgram(NULL), wireframe(0), coldHits(0), drawnChunks(0), drawnTriangles(0), drawTime(0.0f), regionClock(0), lighting(this), octreeCompactedNodes(0)
 {
 	checkCurrentChunk = true;
 	internalFacesCulled = false;
@@ -43,102 +63,682 @@ World::~World() {
 
 }
 
-void World::generate() {
-	// Go through each chunk position
-	for (int cZ = -6; cZ < 6; cZ++) {
-		for (int cY = -4; cY < 5; cY++) {
-			for (int cX = -6; cX < 6; cX++) {
-				// Create a chunk
-				Chunk chunk(cX * 16 * voxelSize, cY * 16 * voxelSize, cZ * 16 * voxelSize, true);
+void World::generate(std::function<void()> pAfterRow) {
+	// Go through each chunk position covering the test world, which is the same size for every chunk size
+	glm::ivec3 minChunk = getVoxelChunkCoordinates(glm::ivec3(-96, -64, -96));
+	glm::ivec3 maxChunk = getVoxelChunkCoordinates(glm::ivec3(96, 80, 96) - 1);
+
+	for (int cZ = minChunk.z; cZ <= maxChunk.z; cZ++) {
+		for (int cY = minChunk.y; cY <= maxChunk.y; cY++) {
+			for (int cX = minChunk.x; cX <= maxChunk.x; cX++) {
+				// Saved chunks are loaded instead of generated again
+				Chunk* chunk = readChunk(cX, cY, cZ);
+				if (!chunk) chunk = addChunk(cX, cY, cZ, true);
+				if (octree && copyToOctree(*chunk, *octree)) octreeChunks.insert(getChunkKey(cX, cY, cZ));
+			}
+		}
+
+		// Lets the caller do other work on this thread in between rows
+		if (pAfterRow) pAfterRow();
+	}
+}
+
+Chunk* World::addChunk(int pX, int pY, int pZ, bool pBounded) {
+	// Create a chunk
+	std::unique_ptr<Chunk>& chunk = chunks[getChunkKey(pX, pY, pZ)];
+	if (chunk) lighting.removeChunk(chunk.get());
+	chunk.reset(new Chunk(pX, pY, pZ, getChunkSize(), true));
+	chunk->setLastVisible(drawTime);
+	lighting.addChunk(chunk.get());
+	markMeshDirty(*chunk);
+
+	// Terrain fills the bottom layers, only in the middle for testing purposes unless the world is streamed
+	glm::ivec3 origin = glm::ivec3(pX, pY, pZ) * getChunkDimensions();
+	glm::ivec3 areaMin(pBounded ? -16 : INT_MIN, 0, pBounded ? -16 : INT_MIN);
+	glm::ivec3 areaMax(pBounded ? 48 : INT_MAX, topLayer, pBounded ? 48 : INT_MAX);
+	if (glm::any(glm::lessThanEqual(origin + getChunkDimensions(), areaMin)) || glm::any(glm::greaterThanEqual(origin, areaMax))) {
+		return chunk.get();
+	}
+
+	// Generate blocks for this chunk, these are random so they have to be saved
+	chunk->setEmpty(false);
+	chunk->setDirty(true);
+	chunk->getBlocks().reserve(Chunk::VOLUME);
+	for (int i = 0; i < Chunk::VOLUME; i++) {
+		glm::ivec3 pos = origin + glm::ivec3(Chunk::getX(i), Chunk::getY(i), Chunk::getZ(i));
+
+		// ID
+		int air = 0;
+		if (glm::all(glm::greaterThanEqual(pos, areaMin)) && glm::all(glm::lessThan(pos, areaMax))) {
+			if (pos.y < topLayer - 1) air = 1;
+			if (pos.y == topLayer - 1) air = Random::range(0, 1);
+		}
+
+		chunk->addBlock(air << 12);
+	}
+
+	return chunk.get();
+}
+
+Chunk* World::loadChunk(int pX, int pY, int pZ) {
+	// The octree backend already holds chunks that were loaded before
+	Chunk* chunk = nullptr;
+	if (octree && octreeChunks.count(getChunkKey(pX, pY, pZ))) {
+		chunk = readOctreeChunk(pX, pY, pZ);
+		if (unloadedEdits.erase(getChunkKey(pX, pY, pZ))) chunk->setDirty(true);
+	}
+
+	// Streamed worlds have an endless terrain layer instead of the test area
+	if (!chunk) {
+		chunk = readChunk(pX, pY, pZ);
+		if (!chunk) chunk = addChunk(pX, pY, pZ, false);
+		if (octree && copyToOctree(*chunk, *octree)) octreeChunks.insert(getChunkKey(pX, pY, pZ));
+	}
+
+	if (internalFacesCulled) {
+		cullFaces(*chunk);
+		updateNeighbours(chunk->getCoordinates());
+	}
+	return chunk;
+}
+
+void World::unloadChunk(int pX, int pY, int pZ) {
+	auto it = chunks.find(getChunkKey(pX, pY, pZ));
+	if (it == chunks.end()) return;
+
+	// Keep changes, they become visible on disk with the next commit
+	if (it->second->isDirty()) writeChunk(*it->second);
+	lighting.removeChunk(it->second.get());
+	chunks.erase(it);
+
+	// The neighbours' faces towards this chunk are visible again
+	if (internalFacesCulled) updateNeighbours(glm::ivec3(pX, pY, pZ));
+}
+
+Chunk* World::getChunk(int pX, int pY, int pZ) {
+	auto it = chunks.find(getChunkKey(pX, pY, pZ));
+	return it == chunks.end() ? nullptr : it->second.get();
+}
+
+Chunk* World::getVoxelChunk(glm::ivec3 pVoxel, int& pIndex) {
+	glm::ivec3 coordinates = getVoxelChunkCoordinates(pVoxel);
+	glm::ivec3 local = pVoxel - coordinates * getChunkDimensions();
+	pIndex = Chunk::getIndex(local.x, local.y, local.z);
+	return getChunk(coordinates.x, coordinates.y, coordinates.z);
+}
+
+std::uint8_t World::getBlock(glm::ivec3 pVoxel) {
+	// Resident chunks are equal to the octree and faster to read, the octree also knows unloaded chunks
+	int index;
+	Chunk* chunk = getVoxelChunk(pVoxel, index);
+	if (!chunk) return octree ? octree->get(pVoxel) : 0;
+	if (chunk->isEmpty()) return 0;
+
+	return (chunk->getBlocks()[index] >> 12) & 0xFF;
+}
+
+std::uint8_t World::getLight(glm::ivec3 pVoxel) {
+	// Outside the loaded chunks there's only open sky
+	int index;
+	Chunk* chunk = getVoxelChunk(pVoxel, index);
+	return chunk ? chunk->getLight(index) : (std::uint8_t)(LightEngine::MAX_LEVEL << 4);
+}
+
+bool World::setBlock(glm::ivec3 pVoxel, std::uint8_t pId) {
+	int index;
+	Chunk* chunk = getVoxelChunk(pVoxel, index);
+	if (!chunk) return setUnloadedBlock(pVoxel, pId);
+	if (!replaceBlock(*chunk, index, pId)) return true;
+
+	chunk->setDirty(true);
+	markMeshDirty(*chunk);
+	glm::ivec3 coordinates = chunk->getCoordinates();
+	markBorderMeshesDirty(coordinates, pVoxel - coordinates * getChunkDimensions());
+
+	// Only the faces between the block and its six neighbours change
+	if (internalFacesCulled) updateFacesAround(pVoxel);
+	return true;
+}
+
+bool World::setUnloadedBlock(glm::ivec3 pVoxel, std::uint8_t pId) {
+	// Only the octree backend can change chunks that aren't loaded, if it has seen them before
+	glm::ivec3 coordinates = getVoxelChunkCoordinates(pVoxel);
+	std::int64_t key = getChunkKey(coordinates.x, coordinates.y, coordinates.z);
+	if (!octree || !octreeChunks.count(key)) return false;
+	if (octree->get(pVoxel) == pId) return true;
+	if (!octree->set(pVoxel, pId)) return false;
+
+	// Written to the chunk's region on the next save
+	unloadedEdits[key] = coordinates;
+	return true;
+}
+
+int World::apply(EditBatch& pBatch) {
+	std::vector<std::pair<Chunk*, EditBatch::ChunkEdits*>> touched;
+	int changed = 0;
+	int dropped = 0;
+
+	// Write the ids of each chunk in one pass
+	for (auto& pair : pBatch.getChunks()) {
+		EditBatch::ChunkEdits& chunkEdits = pair.second;
+		Chunk* chunk = getChunk(chunkEdits.coordinates.x, chunkEdits.coordinates.y, chunkEdits.coordinates.z);
+
+		// Chunks that aren't loaded take the same path as setBlock, only the octree backend can keep those edits
+		if (!chunk) {
+			glm::ivec3 origin = chunkEdits.coordinates * getChunkDimensions();
+			for (const EditBatch::Edit& edit : chunkEdits.edits) {
+				glm::ivec3 voxel = origin + glm::ivec3(Chunk::getX(edit.index), Chunk::getY(edit.index), Chunk::getZ(edit.index));
+				if (getBlock(voxel) == edit.id) continue;
+
+				if (setUnloadedBlock(voxel, edit.id)) changed++;
+				else dropped++;
+			}
+			continue;
+		}
+
+		int chunkChanged = 0;
+		for (const EditBatch::Edit& edit : chunkEdits.edits) {
+			if (!replaceBlock(*chunk, edit.index, edit.id)) continue;
+			markBorderMeshesDirty(chunkEdits.coordinates, glm::ivec3(Chunk::getX(edit.index), Chunk::getY(edit.index), Chunk::getZ(edit.index)));
+			chunkChanged++;
+		}
+		if (chunkChanged == 0) continue;
+
+		chunk->setDirty(true);
+		markMeshDirty(*chunk);
+		touched.push_back(std::make_pair(chunk, &chunkEdits));
+		changed += chunkChanged;
+	}
+
+	// Faces are updated once all ids are in place, large edits recull their chunks in one go
+	if (internalFacesCulled) {
+		for (auto& pair : touched) {
+			Chunk& chunk = *pair.first;
+			const std::vector<EditBatch::Edit>& edits = pair.second->edits;
+
+			if ((int)edits.size() >= Chunk::VOLUME / 8) {
+				cullFaces(chunk);
+				updateNeighbours(chunk.getCoordinates());
+				continue;
+			}
+
+			glm::ivec3 origin = chunk.getCoordinates() * getChunkDimensions();
+			for (const EditBatch::Edit& edit : edits) {
+				updateFacesAround(origin + glm::ivec3(Chunk::getX(edit.index), Chunk::getY(edit.index), Chunk::getZ(edit.index)));
+			}
+		}
+	}
+
+	if (dropped > 0) {
+		std::cout << "[ERROR] " << dropped << " block edits were dropped, their chunks aren't loaded." << std::endl;
+	}
+	return changed;
+}
+
+bool World::replaceBlock(Chunk& pChunk, int pIndex, std::uint8_t pId) {
+	// Empty chunks get their blocks once something is placed in them
+	if (pChunk.isEmpty()) {
+		if (pId == 0) return false;
+
+		std::vector<std::uint8_t> ids(Chunk::VOLUME, 0);
+		pChunk.setBlocks(ids.data(), nullptr);
+		pChunk.setEmpty(false);
+	}
+
+	std::uint32_t& block = pChunk.getBlocks()[pIndex];
+	if (((block >> 12) & 0xFF) == pId) return false;
+
+	block = (block & ~(0xFFu << 12)) | ((std::uint32_t)pId << 12);
+	lighting.blockChanged(&pChunk, pIndex);
+
+	// Every edit goes through here, which keeps the octree backend equal to the resident chunks
+	if (octree) octree->set(pChunk.getCoordinates() * getChunkDimensions() + glm::ivec3(Chunk::getX(pIndex), Chunk::getY(pIndex), Chunk::getZ(pIndex)), pId);
+	return true;
+}
+
+std::int64_t World::getChunkKey(int pX, int pY, int pZ) {
+	// 21 bits per axis is plenty for chunk coordinates
+	std::uint64_t key = 0;
+	key |= (std::uint64_t)(pX & 0x1FFFFF) << 42;
+	key |= (std::uint64_t)(pY & 0x1FFFFF) << 21;
+	key |= (std::uint64_t)(pZ & 0x1FFFFF);
+	return (std::int64_t)key;
+}
+
+glm::ivec3 World::getChunkCoordinatesAt(glm::vec3 pPosition) {
+	return glm::ivec3(glm::floor(pPosition / getChunkSize()));
+}
+
+glm::ivec3 World::getVoxelChunkCoordinates(glm::ivec3 pVoxel) {
+	return floorDivide(pVoxel, getChunkDimensions());
+}
+
+glm::ivec3 World::floorDivide(glm::ivec3 pValue, glm::ivec3 pDivisor) {
+	// Integer division rounds towards zero, negative values have to round down instead
+	glm::ivec3 result;
+	for (int i = 0; i < 3; i++) {
+		result[i] = pValue[i] >= 0 ? pValue[i] / pDivisor[i] : (pValue[i] - pDivisor[i] + 1) / pDivisor[i];
+	}
+	return result;
+}
+
+glm::vec3 World::getChunkSize() {
+	return glm::vec3(getChunkDimensions()) * voxelSize;
+}
+
+float World::getVoxelSize() {
+	return voxelSize;
+}
+
+glm::ivec3 World::getChunkDimensions() {
+	return glm::ivec3(Chunk::SIZE_X, Chunk::SIZE_Y, Chunk::SIZE_Z);
+}
+
+size_t World::getMemoryUsage() {
+	size_t bytes = 0;
+	for (auto& pair : chunks) {
+		bytes += pair.second->getMemoryUsage();
+	}
+	return bytes;
+}
+
+size_t World::getMeshMemoryUsage() {
+	size_t bytes = 0;
+	for (auto& pair : chunks) {
+		bytes += pair.second->getMesh().getMemoryUsage();
+	}
+	return bytes;
+}
+
+int World::getDrawnChunkCount() {
+	return drawnChunks;
+}
+
+int World::getDrawnTriangleCount() {
+	return drawnTriangles;
+}
+
+int World::getColdHitCount() {
+	return coldHits;
+}
+
+void World::setSaveDirectory(const std::string& pDirectory) {
+	commitRegions();
+	regions.clear();
+	regionUses.clear();
+	saveDirectory = pDirectory;
+
+#ifdef _WIN32
+	_mkdir(saveDirectory.c_str());
+#else
+	mkdir(saveDirectory.c_str(), 0755);
+#endif
+}
+
+bool World::save() {
+	if (saveDirectory.empty()) return false;
+
+	// Write the changed chunks, then update the headers of the regions
+	bool success = true;
+	for (auto& pair : chunks) {
+		if (pair.second->isDirty()) success &= writeChunk(*pair.second);
+	}
+	success &= writeUnloadedEdits();
+
+	return commitRegions() && success;
+}
+
+bool World::commitRegions() {
+	bool success = true;
+	for (auto& pair : regions) {
+		if (pair.second) success &= pair.second->commit();
+	}
+	return success;
+}
+
+Chunk* World::readChunk(int pX, int pY, int pZ) {
+	RegionFile* region = getRegion(pX, pY, pZ, false);
+	int x = pX & (RegionFile::SIZE - 1);
+	int z = pZ & (RegionFile::SIZE - 1);
+	if (!region || !region->hasChunk(x, z)) return nullptr;
+
+	// Decode from the mapped file, falling back to reading it into a buffer
+	std::vector<std::uint8_t> buffer;
+	size_t length = 0;
+	const std::uint8_t* data = region->mapChunk(x, z, length);
+	if (!data) {
+		if (!region->readChunk(x, z, buffer)) return nullptr;
+		data = buffer.data();
+		length = buffer.size();
+	}
+
+	// Add the chunk with the saved blocks
+	std::unique_ptr<Chunk> chunk(new Chunk(pX, pY, pZ, getChunkSize(), true));
+	chunk->setLastVisible(drawTime);
+	if (!chunk->decode(data, length)) {
+		std::cout << "[ERROR] Chunk " << pX << ", " << pY << ", " << pZ << " could not be decoded." << std::endl;
+		return nullptr;
+	}
+
+	std::unique_ptr<Chunk>& slot = chunks[getChunkKey(pX, pY, pZ)];
+	if (slot) lighting.removeChunk(slot.get());
+	slot = std::move(chunk);
+	lighting.addChunk(slot.get());
+	markMeshDirty(*slot);
+	return slot.get();
+}
+
+void World::prefetchChunk(int pX, int pY, int pZ) {
+	// Only regions that are open already, opening more could close the ones that are in use
+	RegionFile* region = findRegion(pX, pY, pZ);
+	if (region) region->prefetchChunk(pX & (RegionFile::SIZE - 1), pZ & (RegionFile::SIZE - 1));
+}
+
+bool World::writeChunk(Chunk& pChunk) {
+	glm::ivec3 coordinates = pChunk.getCoordinates();
+	RegionFile* region = getRegion(coordinates.x, coordinates.y, coordinates.z, true);
+	if (!region) return false;
+
+	std::vector<std::uint8_t> data;
+	pChunk.encode(data);
+	if (!region->writeChunk(coordinates.x & (RegionFile::SIZE - 1), coordinates.z & (RegionFile::SIZE - 1), data)) return false;
+
+	pChunk.setDirty(false);
+	return true;
+}
+
+RegionFile* World::getRegion(int pX, int pY, int pZ, bool pCreate) {
+	if (saveDirectory.empty()) return nullptr;
+
+	// Regions span 32x32 chunks of a single chunk layer
+	int rX = pX >> 5;
+	int rZ = pZ >> 5;
+	std::int64_t key = getChunkKey(rX, pY, rZ);
+
+	// Regions without a file are remembered as well, so reads don't keep trying to open them
+	auto it = regions.find(key);
+	if (it != regions.end() && (it->second || !pCreate)) {
+		regionUses[key] = ++regionClock;
+		return it->second.get();
+	}
+
+	// Don't keep too many files open while flying through a streamed world
+	if (it == regions.end() && regions.size() >= 64) closeLeastUsedRegion();
+
+	std::unique_ptr<RegionFile> region(new RegionFile(getRegionPath(pX, pY, pZ)));
+	if (!region->open(pCreate)) region.reset();
+
+	RegionFile* result = region.get();
+	regions[key] = std::move(region);
+	regionUses[key] = ++regionClock;
+	return result;
+}
+
+RegionFile* World::findRegion(int pX, int pY, int pZ) {
+	if (saveDirectory.empty()) return nullptr;
+
+	auto it = regions.find(getChunkKey(pX >> 5, pY, pZ >> 5));
+	return it == regions.end() ? nullptr : it->second.get();
+}
+
+void World::closeLeastUsedRegion() {
+	auto oldest = regionUses.begin();
+	for (auto it = regionUses.begin(); it != regionUses.end(); ++it) {
+		if (it->second < oldest->second) oldest = it;
+	}
+	if (oldest == regionUses.end()) return;
+
+	// Its chunks that were written have to be visible on disk before the file is closed
+	std::unique_ptr<RegionFile>& region = regions[oldest->first];
+	if (region) region->commit();
+	regions.erase(oldest->first);
+	regionUses.erase(oldest);
+}
+
+std::string World::getRegionPath(int pX, int pY, int pZ) {
+	return saveDirectory + "/r." + std::to_string(pX >> 5) + "." + std::to_string(pY) + "." + std::to_string(pZ >> 5) + ".bsr";
+}
+
+bool World::toOctree(Octree& pOctree) {
+	bool success = true;
+	for (auto& pair : chunks) {
+		success &= copyToOctree(*pair.second, pOctree);
+	}
+	return success;
+}
 
-				// Only generate chunks in the middle for testing purposes
-				if (cY == 0 && cX > -2 && cX < 3 && cZ > -2 && cZ < 3) {
-					// Generate blocks for these chunks
-					chunk.setEmpty(false);
-					for (int y = 0; y < 16; y++) {
-						for (int z = 0; z < 16; z++) {
-							for (int x = 0; x < 16; x++) {
-								std::uint32_t block = 0;
+void World::fromOctree(Octree& pOctree, glm::ivec3 pMin, glm::ivec3 pMax) {
+	for (int cZ = pMin.z; cZ <= pMax.z; cZ++) {
+		for (int cY = pMin.y; cY <= pMax.y; cY++) {
+			for (int cX = pMin.x; cX <= pMax.x; cX++) {
+				std::unique_ptr<Chunk>& chunk = chunks[getChunkKey(cX, cY, cZ)];
+				if (chunk) lighting.removeChunk(chunk.get());
+				chunk.reset(new Chunk(cX, cY, cZ, getChunkSize(), true));
+				chunk->setLastVisible(drawTime);
+				copyFromOctree(*chunk, pOctree);
+				lighting.addChunk(chunk.get());
+				markMeshDirty(*chunk);
+				if (octree && copyToOctree(*chunk, *octree)) octreeChunks.insert(getChunkKey(cX, cY, cZ));
+			}
+		}
+	}
 
-								// Position
-								block |= (x << 28);
-								block |= (y << 24);
-								block |= (z << 20);
+	// Faces are culled once all neighbours are there
+	if (internalFacesCulled) internalFaceCull();
+}
 
-								// ID
-								int air = 0;
-								if (y < topLayer - 1) air = 1;
-								if (y == topLayer - 1) air = Random::range(0, 1);
+bool World::setOctreeBackend(bool pEnabled) {
+	if (!pEnabled) {
+		// Resident chunks already have every edit, unloaded ones were written to their region when they were unloaded.
+		// Only edits made to unloaded chunks through the octree still have to be written.
+		if (octree && !writeUnloadedEdits()) {
+			std::cout << "[ERROR] Edits to unloaded chunks could not be saved, keeping the octree backend." << std::endl;
+			return false;
+		}
+		octree.reset();
+		octreeChunks.clear();
+		octreeCompactedNodes = 0;
+		return true;
+	}
+	if (octree) return true;
 
-								block |= (air << 12);
+	std::unique_ptr<Octree> tree(new Octree(octreeDepth));
+	std::unordered_set<std::int64_t> keys;
+	for (auto& pair : chunks) {
+		if (!copyToOctree(*pair.second, *tree)) return false;
+		keys.insert(pair.first);
+	}
 
-								chunk.addBlock(block);
-							}
+	octree = std::move(tree);
+	octreeChunks.swap(keys);
+	octreeCompactedNodes = 0;
+	compactOctree();
+	return true;
+}
+
+bool World::isOctreeBackend() {
+	return octree != nullptr;
+}
+
+size_t World::getOctreeMemoryUsage() {
+	return octree ? octree->getMemoryUsage() : 0;
+}
+
+void World::compactOctree() {
+	// Deduplicating goes through the whole tree, so it waits until the tree grew by a quarter since the last time
+	if (!octree || octree->getNodeCount() <= octreeCompactedNodes + octreeCompactedNodes / 4) return;
+
+	octree->deduplicate();
+	octreeCompactedNodes = octree->getNodeCount();
+}
+
+void World::forEachBlock(glm::ivec3 pMin, glm::ivec3 pMax, std::function<void(glm::ivec3, std::uint8_t)> pFunction) {
+	// Visits every block that isn't air in [pMin, pMax)
+	if (octree) {
+		octree->forEach(pMin, pMax, pFunction);
+		return;
+	}
+
+	glm::ivec3 minChunk = getVoxelChunkCoordinates(pMin);
+	glm::ivec3 maxChunk = getVoxelChunkCoordinates(pMax - 1);
+	for (int cZ = minChunk.z; cZ <= maxChunk.z; cZ++) {
+		for (int cY = minChunk.y; cY <= maxChunk.y; cY++) {
+			for (int cX = minChunk.x; cX <= maxChunk.x; cX++) {
+				Chunk* chunk = getChunk(cX, cY, cZ);
+				if (!chunk || chunk->isEmpty()) continue;
+
+				glm::ivec3 origin = glm::ivec3(cX, cY, cZ) * getChunkDimensions();
+				glm::ivec3 low = glm::max(pMin, origin) - origin;
+				glm::ivec3 high = glm::min(pMax, origin + getChunkDimensions()) - origin;
+				std::vector<std::uint32_t>& blocks = chunk->getBlocks();
+				for (int y = low.y; y < high.y; y++) {
+					for (int z = low.z; z < high.z; z++) {
+						for (int x = low.x; x < high.x; x++) {
+							std::uint8_t id = (blocks[Chunk::getIndex(x, y, z)] >> 12) & 0xFF;
+							if (id != 0) pFunction(origin + glm::ivec3(x, y, z), id);
 						}
 					}
 				}
+			}
+		}
+	}
+}
+
+bool World::writeUnloadedEdits() {
+	// Without a save directory they're lost like any other chunk that is unloaded
+	if (saveDirectory.empty()) {
+		unloadedEdits.clear();
+		return true;
+	}
 
-				chunks.push_back(chunk);
+	bool success = true;
+	for (auto it = unloadedEdits.begin(); it != unloadedEdits.end();) {
+		// Chunks that were loaded again since then are written with the resident chunks
+		if (!chunks.count(it->first)) {
+			Chunk chunk(it->second.x, it->second.y, it->second.z, getChunkSize(), true);
+			copyFromOctree(chunk, *octree);
+			if (!writeChunk(chunk)) {
+				success = false;
+				++it;
+				continue;
 			}
 		}
+		it = unloadedEdits.erase(it);
+	}
+	return success;
+}
+
+Chunk* World::readOctreeChunk(int pX, int pY, int pZ) {
+	std::unique_ptr<Chunk>& chunk = chunks[getChunkKey(pX, pY, pZ)];
+	if (chunk) lighting.removeChunk(chunk.get());
+	chunk.reset(new Chunk(pX, pY, pZ, getChunkSize(), true));
+	chunk->setLastVisible(drawTime);
+	copyFromOctree(*chunk, *octree);
+	lighting.addChunk(chunk.get());
+	markMeshDirty(*chunk);
+	return chunk.get();
+}
+
+bool World::copyToOctree(Chunk& pChunk, Octree& pOctree) {
+	// Chunks that don't fit are reported once instead of for every voxel
+	glm::ivec3 origin = pChunk.getCoordinates() * getChunkDimensions();
+	if (!pOctree.contains(origin) || !pOctree.contains(origin + getChunkDimensions() - 1)) {
+		glm::ivec3 coordinates = pChunk.getCoordinates();
+		std::cout << "[ERROR] Chunk " << coordinates.x << ", " << coordinates.y << ", " << coordinates.z << " is outside the octree, which covers voxels "
+			<< -pOctree.getSize() / 2 << " to " << pOctree.getSize() / 2 - 1 << " along each axis." << std::endl;
+		return false;
+	}
+	if (pChunk.isEmpty()) return true;
+
+	// Insert every block that isn't air at its voxel position
+	std::vector<std::uint32_t>& blocks = pChunk.getBlocks();
+	for (int i = 0; i < (int)blocks.size(); i++) {
+		int id = (blocks[i] >> 12) & 0xFF;
+		if (id == 0) continue;
+
+		pOctree.set(origin + glm::ivec3(Chunk::getX(i), Chunk::getY(i), Chunk::getZ(i)), (std::uint8_t)id);
+	}
+	return true;
+}
+
+void World::copyFromOctree(Chunk& pChunk, Octree& pOctree) {
+	// Only the blocks that aren't air are visited
+	glm::ivec3 origin = pChunk.getCoordinates() * getChunkDimensions();
+	std::vector<std::uint8_t> ids(Chunk::VOLUME, 0);
+	bool filled = false;
+	pOctree.forEach(origin, origin + getChunkDimensions(), [&](glm::ivec3 pPosition, std::uint8_t pId) {
+		glm::ivec3 local = pPosition - origin;
+		ids[Chunk::getIndex(local.x, local.y, local.z)] = pId;
+		filled = true;
+	});
+
+	if (filled) {
+		pChunk.setBlocks(ids.data(), nullptr);
+		pChunk.setEmpty(false);
 	}
 }
 
 void World::clear() {
 	internalFacesCulled = false;
+	lighting.clear();
 	chunks.clear();
+	dirtyMeshes.clear();
+	if (octree) octree->clear();
+	octreeChunks.clear();
+	octreeCompactedNodes = 0;
+	unloadedEdits.clear();
 }
 
 void World::checkChunk(bool pIgnoreIfCurrentChunk) {
+	PROFILE_SCOPE("World::checkChunk");
+
 	// No longer check the chunks
 	setCheckChunk(false);
 
 	// Get the camera's position
 	glm::vec3 pos = camera->getLocked() ? camera->getLockedPosition() : camera->getPosition();
 
-	// Go through the chunks
-	for (Chunk& chunk : chunks) {
-		// If the camera is in that chunk
-		if (pos.x > chunk.getPosition().x && pos.x < chunk.getPosition().x + 16 * voxelSize &&
-			pos.y > chunk.getPosition().y && pos.y < chunk.getPosition().y + 16 * voxelSize &&
-			pos.z > chunk.getPosition().z && pos.z < chunk.getPosition().z + 16 * voxelSize) {
-
-			glm::vec3 newClosest = chunk.getPosition();
-
-			// Check if it's not the current chunk
-			if (newClosest != closestChunkPos || pIgnoreIfCurrentChunk) {
-				closestChunkPos = newClosest;
-
-				// Make sure current chunk can be seen entirely
-				chunk.setIgnoreRight(false);
-				chunk.setIgnoreLeft(false);
-				chunk.setIgnoreUp(false);
-				chunk.setIgnoreDown(false);
-				chunk.setIgnoreFront(false);
-				chunk.setIgnoreBack(false);
-
-				// Go through all chunks
-				for (Chunk& chunkCopy : chunks) {
-					// Ignore current chunk and empty chunks
-					if (chunkCopy.getPosition() == closestChunkPos || chunkCopy.isEmpty()) continue;
-
-					// Have the renderer ignore some faces depending on where the chunk is
-					chunkCopy.setIgnoreLeft(chunkCopy.getPosition().x < closestChunkPos.x);
-					chunkCopy.setIgnoreRight(chunkCopy.getPosition().x > closestChunkPos.x);
-					chunkCopy.setIgnoreDown(chunkCopy.getPosition().y < closestChunkPos.y);
-					chunkCopy.setIgnoreUp(chunkCopy.getPosition().y > closestChunkPos.y);
-					chunkCopy.setIgnoreBack(chunkCopy.getPosition().z > closestChunkPos.z);
-					chunkCopy.setIgnoreFront(chunkCopy.getPosition().z < closestChunkPos.z);
-				}
-			}
+	// Find the chunk the camera is in
+	glm::ivec3 coordinates = getChunkCoordinatesAt(pos);
+	Chunk* current = getChunk(coordinates.x, coordinates.y, coordinates.z);
+	if (!current) return;
+
+	glm::vec3 newClosest = current->getPosition();
+
+	// Check if it's not the current chunk
+	if (newClosest != closestChunkPos || pIgnoreIfCurrentChunk) {
+		closestChunkPos = newClosest;
 
-			break;
+		// Make sure current chunk can be seen entirely
+		current->setIgnoreRight(false);
+		current->setIgnoreLeft(false);
+		current->setIgnoreUp(false);
+		current->setIgnoreDown(false);
+		current->setIgnoreFront(false);
+		current->setIgnoreBack(false);
+
+		// Go through all chunks
+		for (auto& pairCopy : chunks) {
+			Chunk& chunkCopy = *pairCopy.second;
+
+			// Ignore current chunk and empty chunks
+			if (chunkCopy.getPosition() == closestChunkPos || chunkCopy.isEmpty()) continue;
+
+			// Have the renderer ignore some faces depending on where the chunk is
+			chunkCopy.setIgnoreLeft(chunkCopy.getPosition().x < closestChunkPos.x);
+			chunkCopy.setIgnoreRight(chunkCopy.getPosition().x > closestChunkPos.x);
+			chunkCopy.setIgnoreDown(chunkCopy.getPosition().y < closestChunkPos.y);
+			chunkCopy.setIgnoreUp(chunkCopy.getPosition().y > closestChunkPos.y);
+			chunkCopy.setIgnoreBack(chunkCopy.getPosition().z > closestChunkPos.z);
+			chunkCopy.setIgnoreFront(chunkCopy.getPosition().z < closestChunkPos.z);
 		}
 	}
 }
 
 void World::enableAllFaces() {
-	for (Chunk& chunk : chunks) {
+	for (auto& pair : chunks) {
+		Chunk& chunk = *pair.second;
+
 		chunk.setIgnoreRight(false);
 		chunk.setIgnoreLeft(false);
 		chunk.setIgnoreUp(false);
@@ -156,7 +756,7 @@ glm::vec3 World::getClosestChunkPosition() {
 	return closestChunkPos;
 }
 
-std::vector<Chunk> World::getChunks() {
+std::unordered_map<std::int64_t, std::unique_ptr<Chunk>>& World::getChunks() {
 	return chunks;
 }
 
@@ -173,138 +773,340 @@ int World::getWireframeColour() {
 }
 
 void World::draw() {
-	for (Chunk chunk : chunks) {
+	PROFILE_SCOPE("World::draw");
+
+	float time = (float)glfwGetTime();
+	drawTime = time;
+
+	// Set render colour, vertices are in voxels from the chunk's origin
+	GLuint originLoc = glGetUniformLocation(shaderProgram, "chunkOrigin");
+	GLuint colLoc = glGetUniformLocation(shaderProgram, "col");
+	glUniform3f(colLoc, wireframe, wireframe, wireframe);
+	glUniform1f(glGetUniformLocation(shaderProgram, "voxelSize"), voxelSize);
+
+	drawnChunks = 0;
+	drawnTriangles = 0;
+	for (auto& pair : chunks) {
+		Chunk& chunk = *pair.second;
+
 		// Ignore empty chunks
 		if (chunk.isEmpty()) continue;
 
-		for (const auto& block : chunk.getBlocks()) {
-			// Ignore air blocks
-			int id = (block >> 12) & 0xFF;
-			if (id == 0) continue;
+		// Remember when the chunk was last in view, the streamer compresses and evicts the oldest ones first.
+		// Compressed chunks lose their mesh, which is rebuilt once they're in view again.
+		if (isChunkVisible(chunk.getCoordinates())) {
+			chunk.setLastVisible(time);
+			if (chunk.isMeshDirty()) dirtyMeshes.insert(pair.first);
+		}
 
-			int x = (block >> 28) & 0x0F;
-			int y = (block >> 24) & 0x0F;
-			int z = (block >> 20) & 0x0F;
-
-			// Get the position of the block
-			glm::vec3 pos(glm::vec3(x * voxelSize, y * voxelSize, z * voxelSize) + chunk.getPosition());
-
-			// Check which faces to draw
-			int left = 0;
-			int right = 0;
-			int down = 0;
-			int up = 0;
-			int front = 0;
-			int back = 0;
-
-			if (internalFacesCulled) {
-				left = (block >> 11) & 0x01;
-				right = (block >> 10) & 0x01;
-				down = (block >> 9) & 0x01;
-				up = (block >> 8) & 0x01;
-				front = (block >> 7) & 0x01;
-				back = (block >> 6) & 0x01;
-			}
+		// Set the chunk's origin
+		glUniform3fv(originLoc, 1, glm::value_ptr(chunk.getPosition()));
+
+		// Draw the faces of the directions that aren't ignored
+		bool sections[6] = {
+			!chunk.getIgnoreLeft(),
+			!chunk.getIgnoreRight(),
+			!chunk.getIgnoreDown(),
+			!chunk.getIgnoreUp(),
+			!chunk.getIgnoreFront(),
+			!chunk.getIgnoreBack()
+		};
+		int triangles = chunk.getMesh().draw(sections);
+		if (triangles > 0) drawnChunks++;
+		drawnTriangles += triangles;
+	}
+}
+
+int World::updateMeshes() {
+	PROFILE_SCOPE("World::updateMeshes");
+
+	// Compressed chunks queued for a mesh are back in view, that's when a cold chunk counts as used again
+	for (std::int64_t key : dirtyMeshes) {
+		auto it = chunks.find(key);
+		if (it != chunks.end() && it->second->isCompressed()) coldHits++;
+	}
+
+	// Only chunks that changed are rebuilt, including the ones where light changed
+	lighting.update();
+
+	int count = 0;
+	for (std::int64_t key : dirtyMeshes) {
+		auto it = chunks.find(key);
+		if (it == chunks.end() || !it->second->isMeshDirty()) continue;
+
+		buildMesh(*it->second);
+		count++;
+	}
+	dirtyMeshes.clear();
+	return count;
+}
+
+void World::markMeshDirty(Chunk& pChunk) {
+	// Queued so updating the meshes doesn't have to look through every chunk
+	pChunk.setMeshDirty(true);
+	glm::ivec3 coordinates = pChunk.getCoordinates();
+	dirtyMeshes.insert(getChunkKey(coordinates.x, coordinates.y, coordinates.z));
+}
+
+void World::buildMesh(Chunk& pChunk) {
+	pChunk.setMeshDirty(false);
+	if (pChunk.isEmpty()) {
+		pChunk.getMesh().destroy();
+		return;
+	}
+
+	std::vector<ChunkVertex> vertices;
+	std::vector<GLuint> indices;
+	int sectionCounts[6];
 
-			// Set model uniform
-			GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-			glm::mat4 model = glm::translate(glm::mat4(1.0f), pos);
-			glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+	// Blocks of the chunk and the 26 around it, ambient occlusion looks just across the borders.
+	// Compressed neighbours only have their ids read into a buffer, so they stay compressed.
+	const std::uint32_t* around[27];
+	const std::uint8_t* aroundIds[27];
+	std::vector<std::uint8_t> coldIds[27];
+	glm::ivec3 coordinates = pChunk.getCoordinates();
+	for (int i = 0; i < 27; i++) {
+		Chunk* chunk = getChunk(coordinates.x + i % 3 - 1, coordinates.y + i / 9 - 1, coordinates.z + (i / 3) % 3 - 1);
+		around[i] = nullptr;
+		aroundIds[i] = nullptr;
+		if (!chunk || chunk->isEmpty()) continue;
 
-			// Set render colour
-			GLuint colLoc = glGetUniformLocation(shaderProgram, "col");
-			glUniform3f(colLoc, wireframe, wireframe, wireframe);
+		if (chunk != &pChunk && chunk->isCompressed() && chunk->readCompressedIds(coldIds[i])) aroundIds[i] = coldIds[i].data();
+		else around[i] = chunk->getBlocks().data();
+	}
+	glm::ivec3 dimensions = getChunkDimensions();
+	auto isSolid = [&](glm::ivec3 pLocal) {
+		glm::ivec3 offset = glm::ivec3(glm::greaterThanEqual(pLocal, dimensions)) - glm::ivec3(glm::lessThan(pLocal, glm::ivec3(0)));
+		int neighbour = (offset.y + 1) * 9 + (offset.z + 1) * 3 + offset.x + 1;
+		glm::ivec3 local = pLocal - offset * dimensions;
+		int index = Chunk::getIndex(local.x, local.y, local.z);
 
-			// Get all indices
-			std::vector<GLuint> combinedIndices;
+		if (around[neighbour]) return ((around[neighbour][index] >> 12) & 0xFF) != 0;
+		return aroundIds[neighbour] && aroundIds[neighbour][index] != 0;
+	};
 
-			if (left == 0 &&  !chunk.getIgnoreLeft())  combinedIndices.insert(combinedIndices.end(), std::begin(cubeIndicesLeft),   std::end(cubeIndicesLeft));
-			if (right == 0 && !chunk.getIgnoreRight()) combinedIndices.insert(combinedIndices.end(), std::begin(cubeIndicesRight),  std::end(cubeIndicesRight));
-			if (up == 0 &&    !chunk.getIgnoreUp())    combinedIndices.insert(combinedIndices.end(), std::begin(cubeIndicesTop),    std::end(cubeIndicesTop));
-			if (down == 0 &&  !chunk.getIgnoreDown())  combinedIndices.insert(combinedIndices.end(), std::begin(cubeIndicesBottom), std::end(cubeIndicesBottom));
-			if (front == 0 && !chunk.getIgnoreFront()) combinedIndices.insert(combinedIndices.end(), std::begin(cubeIndicesFront),  std::end(cubeIndicesFront));
-			if (back == 0 &&  !chunk.getIgnoreBack())  combinedIndices.insert(combinedIndices.end(), std::begin(cubeIndicesBack),   std::end(cubeIndicesBack));
+	// Faces are grouped per direction, so the ones facing away from the camera can be skipped
+	std::vector<std::uint32_t>& blocks = pChunk.getBlocks();
+	for (int dir = 0; dir < 6; dir++) {
+		size_t sectionStart = indices.size();
+		int axisA = (dir / 2 + 1) % 3;
+		int axisB = (dir / 2 + 2) % 3;
 
-			// Bind the EBO and assign the indices
-			renderer->bindEBO();
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, combinedIndices.size() * sizeof(GLuint), combinedIndices.data(), GL_STATIC_DRAW);
+		for (int i = 0; i < (int)blocks.size(); i++) {
+			// Ignore air blocks and faces that are covered
+			std::uint32_t block = blocks[i];
+			int id = (block >> 12) & 0xFF;
+			if (id == 0) continue;
+			if (internalFacesCulled && ((block >> (11 - dir)) & 0x01)) continue;
+
+			// Get the position of the block in the chunk and the light in front of the face
+			glm::ivec3 local(Chunk::getX(i), Chunk::getY(i), Chunk::getZ(i));
+			std::uint32_t position = (std::uint32_t)(local.x | (local.y << 6) | (local.z << 12) | (dir << 21));
+			std::uint32_t light = getNeighbourLight(pChunk, i, dir);
+
+			// Each corner is darkened by the blocks next to it in front of the face
+			glm::ivec3 front = local + glm::ivec3(faceDirections[dir][0], faceDirections[dir][1], faceDirections[dir][2]);
+			int occlusion[4];
+			for (int c = 0; c < 4; c++) {
+				int corner = faceCorners[dir][c];
+				glm::ivec3 sideA(0);
+				glm::ivec3 sideB(0);
+				sideA[axisA] = ((corner >> axisA) & 1) ? 1 : -1;
+				sideB[axisB] = ((corner >> axisB) & 1) ? 1 : -1;
+				occlusion[c] = getOcclusion(isSolid(front + sideA), isSolid(front + sideB), isSolid(front + sideA + sideB));
+			}
 
-			// Draw the block's triangles and unbind the EBO
-			glDrawElements(GL_TRIANGLES, combinedIndices.size(), GL_UNSIGNED_INT, 0);
-			renderer->unbindEBO();
+			GLuint base = (GLuint)vertices.size();
+			for (int c = 0; c < 4; c++) {
+				int corner = faceCorners[dir][c];
+
+				ChunkVertex vertex;
+				vertex.position = position | ((std::uint32_t)corner << 18) | ((std::uint32_t)occlusion[c] << 24);
+				vertex.block = light | ((std::uint32_t)id << 8);
+				vertices.push_back(vertex);
+			}
+
+			// Split along the darker diagonal, otherwise the darkening depends on which way the face is turned
+			const unsigned int* quad = occlusion[0] + occlusion[2] > occlusion[1] + occlusion[3] ? flippedFaceIndices : faceIndices;
+			for (int k = 0; k < 6; k++) {
+				indices.push_back(base + quad[k]);
+			}
 		}
+
+		sectionCounts[dir] = (int)(indices.size() - sectionStart);
 	}
+
+	if (indices.empty()) pChunk.getMesh().destroy();
+	else pChunk.getMesh().upload(vertices, indices, sectionCounts);
 }
 
-int World::isNeighbourPresent(const std::vector<std::uint32_t>& blocks, int index, int dir) {
-	// Get the block's position
-	std::uint32_t block = blocks[index];
-	int x = (block >> 28) & 0x0F;
-	int y = (block >> 24) & 0x0F;
-	int z = (block >> 20) & 0x0F;
-
-	// Update index depending on where to look
-	switch (dir) {
-	case 0: // Left
-		if (x == 0) return 0;
-		index -= 1;
-		break;
-	case 1: // Right
-		if (x == 15) return 0;
-		index += 1;
-		break;
-	case 2: // Down
-		if (y == 0) return 0;
-		index -= 256;
-		break;
-	case 3: // Up
-		if (y == 15) return 0;
-		index += 256;
-		break;
-	case 4: // Front
-		if (z == 0) return 0;
-		index -= 16;
-		break;
-	case 5: // Back
-		if (z == 15) return 0;
-		index += 16;
-		break;
+int World::isNeighbourPresent(Chunk& pChunk, int index, int dir) {
+	// Get the neighbouring block's position
+	int x = Chunk::getX(index) + faceDirections[dir][0];
+	int y = Chunk::getY(index) + faceDirections[dir][1];
+	int z = Chunk::getZ(index) + faceDirections[dir][2];
+
+	// Blocks on the border look into the neighbouring chunk
+	Chunk* chunk = &pChunk;
+	if (x < 0 || x >= Chunk::SIZE_X || y < 0 || y >= Chunk::SIZE_Y || z < 0 || z >= Chunk::SIZE_Z) {
+		glm::ivec3 coordinates = pChunk.getCoordinates() + glm::ivec3(faceDirections[dir][0], faceDirections[dir][1], faceDirections[dir][2]);
+		chunk = getChunk(coordinates.x, coordinates.y, coordinates.z);
+		if (!chunk || chunk->isEmpty()) return 0;
+
+		x = (x + Chunk::SIZE_X) % Chunk::SIZE_X;
+		y = (y + Chunk::SIZE_Y) % Chunk::SIZE_Y;
+		z = (z + Chunk::SIZE_Z) % Chunk::SIZE_Z;
 	}
 
 	// Get the neighbouring block's id
-	block = blocks[index];
+	std::uint32_t block = chunk->getBlocks()[Chunk::getIndex(x, y, z)];
 	int id = (block >> 12) & 0xFF;
 	return id == 0 ? 0 : 1;
 }
 
+std::uint8_t World::getNeighbourLight(Chunk& pChunk, int pIndex, int pDir) {
+	int x = Chunk::getX(pIndex) + faceDirections[pDir][0];
+	int y = Chunk::getY(pIndex) + faceDirections[pDir][1];
+	int z = Chunk::getZ(pIndex) + faceDirections[pDir][2];
+	if (x >= 0 && x < Chunk::SIZE_X && y >= 0 && y < Chunk::SIZE_Y && z >= 0 && z < Chunk::SIZE_Z) return pChunk.getLight(Chunk::getIndex(x, y, z));
+
+	// Faces on the border show the light of the neighbouring chunk
+	glm::ivec3 coordinates = pChunk.getCoordinates() + glm::ivec3(faceDirections[pDir][0], faceDirections[pDir][1], faceDirections[pDir][2]);
+	Chunk* chunk = getChunk(coordinates.x, coordinates.y, coordinates.z);
+	if (!chunk) return (std::uint8_t)(LightEngine::MAX_LEVEL << 4);
+
+	return chunk->getLight(Chunk::getIndex((x + Chunk::SIZE_X) % Chunk::SIZE_X, (y + Chunk::SIZE_Y) % Chunk::SIZE_Y, (z + Chunk::SIZE_Z) % Chunk::SIZE_Z));
+}
+
 void World::internalFaceCull() {
 	internalFacesCulled = true;
-	for (Chunk& chunk : chunks) {
-		std::vector<std::uint32_t>& blocks = chunk.getBlocks();
+	for (auto& pair : chunks) {
+		cullFaces(*pair.second);
+	}
+}
 
-		for (size_t i = 0; i < blocks.size(); ++i) {
-			// Ignore air blocks
-			std::uint32_t block = blocks[i];
-			int id = (block >> 12) & 0xFF;
-			if (id == 0) continue;
+void World::showInternalFaces() {
+	internalFacesCulled = false;
+	for (auto& pair : chunks) {
+		markMeshDirty(*pair.second);
+	}
+}
+
+void World::cullFaces(Chunk& pChunk) {
+	if (pChunk.isEmpty()) return;
+
+	for (int i = 0; i < Chunk::VOLUME; ++i) {
+		updateFaces(pChunk, i);
+	}
+	markMeshDirty(pChunk);
+}
+
+void World::updateFaces(Chunk& pChunk, int pIndex) {
+	std::uint32_t& block = pChunk.getBlocks()[pIndex];
+
+	// Check which faces to draw, air blocks have none
+	block &= ~(0x3F << 6);
+	int id = (block >> 12) & 0xFF;
+	if (id == 0) return;
+
+	for (int j = 0; j < 6; ++j) {
+		if (isNeighbourPresent(pChunk, pIndex, j)) {
+			block |= (1 << (11 - j));
+		}
+	}
+}
+
+void World::updateFacesAround(glm::ivec3 pVoxel) {
+	// The neighbours can be in the neighbouring chunks, which then need a new mesh as well
+	for (int i = -1; i < 6; i++) {
+		glm::ivec3 voxel = pVoxel;
+		if (i >= 0) voxel += glm::ivec3(faceDirections[i][0], faceDirections[i][1], faceDirections[i][2]);
+
+		int index;
+		Chunk* chunk = getVoxelChunk(voxel, index);
+		if (!chunk || chunk->isEmpty()) continue;
+
+		updateFaces(*chunk, index);
+		markMeshDirty(*chunk);
+	}
+}
+
+void World::updateNeighbours(glm::ivec3 pCoordinates) {
+	for (int dir = 0; dir < 6; dir++) {
+		glm::ivec3 coordinates = pCoordinates + glm::ivec3(faceDirections[dir][0], faceDirections[dir][1], faceDirections[dir][2]);
+		Chunk* neighbour = getChunk(coordinates.x, coordinates.y, coordinates.z);
+		if (!neighbour || neighbour->isEmpty()) continue;
 
-			// Make a copy of the block
-			std::uint32_t blockCopy = block;
+		// Only the neighbour's blocks on the side facing the chunk are updated
+		int axis = dir / 2;
+		glm::ivec3 from(0);
+		glm::ivec3 to = getChunkDimensions() - 1;
+		if (dir % 2 == 0) from[axis] = to[axis];
+		else to[axis] = 0;
 
-			// Check which faces to draw
-			blockCopy &= ~(0x3F << 6);
-			for (int j = 0; j < 6; ++j) {
-				if (isNeighbourPresent(blocks, i, j)) {
-					blockCopy |= (1 << (11 - j));
+		for (int y = from.y; y <= to.y; y++) {
+			for (int z = from.z; z <= to.z; z++) {
+				for (int x = from.x; x <= to.x; x++) {
+					updateFaces(*neighbour, Chunk::getIndex(x, y, z));
 				}
 			}
+		}
+		markMeshDirty(*neighbour);
+	}
+}
+
+void World::markBorderMeshesDirty(glm::ivec3 pCoordinates, glm::ivec3 pLocal) {
+	// Occlusion is sampled across chunk borders, so a block on a face, edge or corner of its chunk
+	// shades the meshes of up to seven chunks around it
+	glm::ivec3 low(0);
+	glm::ivec3 high(0);
+	glm::ivec3 dimensions = getChunkDimensions();
+	for (int axis = 0; axis < 3; axis++) {
+		if (pLocal[axis] == 0) low[axis] = -1;
+		if (pLocal[axis] == dimensions[axis] - 1) high[axis] = 1;
+	}
+
+	for (int y = low.y; y <= high.y; y++) {
+		for (int z = low.z; z <= high.z; z++) {
+			for (int x = low.x; x <= high.x; x++) {
+				if (x == 0 && y == 0 && z == 0) continue;
 
-			// Update the block
-			blocks[i] = blockCopy;
+				Chunk* neighbour = getChunk(pCoordinates.x + x, pCoordinates.y + y, pCoordinates.z + z);
+				if (neighbour && !neighbour->isEmpty()) markMeshDirty(*neighbour);
+			}
 		}
 	}
 }
 
+bool World::isChunkVisible(glm::ivec3 pCoordinates) {
+	// Compare the direction to the chunk's centre with the camera's view direction
+	float radius = glm::length(getChunkSize()) * 0.5f;
+	glm::vec3 toChunk = (glm::vec3(pCoordinates) + 0.5f) * getChunkSize() - camera->getPosition();
+	float distance = glm::length(toChunk);
+	if (distance < radius) return true;
+
+	// The field of view is used as the half angle, which also covers the wider horizontal view
+	float angle = glm::radians(camera->getFov()) + asin(radius / distance);
+	if (angle >= glm::radians(90.0f)) return glm::dot(toChunk, camera->getFront()) > -radius;
+	return glm::dot(toChunk / distance, camera->getFront()) > cos(angle);
+}
+
+int World::getCornerOcclusion(glm::ivec3 pVoxel, int pDir, int pCorner) {
+	// Same as the meshes, for a corner given by its bits along x (1), y (2) and z (4)
+	glm::ivec3 front = pVoxel + glm::ivec3(faceDirections[pDir][0], faceDirections[pDir][1], faceDirections[pDir][2]);
+	glm::ivec3 sideA(0);
+	glm::ivec3 sideB(0);
+	int axisA = (pDir / 2 + 1) % 3;
+	int axisB = (pDir / 2 + 2) % 3;
+	sideA[axisA] = ((pCorner >> axisA) & 1) ? 1 : -1;
+	sideB[axisB] = ((pCorner >> axisB) & 1) ? 1 : -1;
+	return getOcclusion(getBlock(front + sideA) != 0, getBlock(front + sideB) != 0, getBlock(front + sideA + sideB) != 0);
+}
+
+LightEngine& World::getLighting() {
+	return lighting;
+}
+
 bool World::areInternalFacesCulled() {
 	return internalFacesCulled;
 }
\ No newline at end of file
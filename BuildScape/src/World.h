@@ -1,11 +1,20 @@
 #pragma once
 
 #include <vector>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <string>
 
 #include "Chunk.h"
 #include "Camera.h"
 #include "Renderer.h"
 #include "Random.h"
+#include "RegionFile.h"
+#include "Octree.h"
+#include "EditBatch.h"
+#include "LightEngine.h"
 #include "GL/glew.h"
 
 #include "glm/glm.hpp"
@@ -17,24 +26,64 @@ public:
 	World(float pVoxelSize, int pTopLayer, Camera* pCamera, Renderer* pRenderer);
 	~World();
 
-	void generate();
+	void generate(std::function<void()> pAfterRow = nullptr);
 	void clear();
 	void checkChunk(bool pIgnoreIfCurrentChunk);
 	void enableAllFaces();
 	void setCheckChunk(bool pCheck);
 	glm::vec3 getClosestChunkPosition();
-	std::vector<Chunk> getChunks();
+	std::unordered_map<std::int64_t, std::unique_ptr<Chunk>>& getChunks();
 	void setShaderProgram(GLuint pShaderProgram);
 
+	static std::int64_t getChunkKey(int pX, int pY, int pZ);
+	Chunk* getChunk(int pX, int pY, int pZ);
+	Chunk* loadChunk(int pX, int pY, int pZ);
+	void unloadChunk(int pX, int pY, int pZ);
+	void prefetchChunk(int pX, int pY, int pZ);
+	std::uint8_t getBlock(glm::ivec3 pVoxel);
+	std::uint8_t getLight(glm::ivec3 pVoxel);
+	int getCornerOcclusion(glm::ivec3 pVoxel, int pDir, int pCorner);
+	bool setBlock(glm::ivec3 pVoxel, std::uint8_t pId);
+	int apply(EditBatch& pBatch);
+	glm::ivec3 getChunkCoordinatesAt(glm::vec3 pPosition);
+	static glm::ivec3 getVoxelChunkCoordinates(glm::ivec3 pVoxel);
+	static glm::ivec3 floorDivide(glm::ivec3 pValue, glm::ivec3 pDivisor);
+	glm::vec3 getChunkSize();
+	float getVoxelSize();
+	static glm::ivec3 getChunkDimensions();
+	size_t getMemoryUsage();
+	size_t getMeshMemoryUsage();
+	int getDrawnChunkCount();
+	int getDrawnTriangleCount();
+	int getColdHitCount();
+
+	void setSaveDirectory(const std::string& pDirectory);
+	bool save();
+	bool commitRegions();
+	std::string getRegionPath(int pX, int pY, int pZ);
+
+	bool toOctree(Octree& pOctree);
+	void fromOctree(Octree& pOctree, glm::ivec3 pMin, glm::ivec3 pMax);
+	bool setOctreeBackend(bool pEnabled);
+	bool isOctreeBackend();
+	size_t getOctreeMemoryUsage();
+	void compactOctree();
+	void forEachBlock(glm::ivec3 pMin, glm::ivec3 pMax, std::function<void(glm::ivec3, std::uint8_t)> pFunction);
+
 	void internalFaceCull();
+	void showInternalFaces();
 	bool areInternalFacesCulled();
 
 	void setWireframeColour(int pColour);
 	int getWireframeColour();
 	void draw();
+	int updateMeshes();
+	void markMeshDirty(Chunk& pChunk);
+	LightEngine& getLighting();
+	bool isChunkVisible(glm::ivec3 pCoordinates);
 
 private:
-	std::vector<Chunk> chunks;
+	std::unordered_map<std::int64_t, std::unique_ptr<Chunk>> chunks;
 	bool checkCurrentChunk;
 	glm::vec3 closestChunkPos;
 	float voxelSize;
@@ -42,9 +91,57 @@ private:
 	bool internalFacesCulled;
 	int wireframe;
 
+	// Chunks whose mesh has to be rebuilt, by key
+	std::unordered_set<std::int64_t> dirtyMeshes;
+	// Compressed chunks that were meshed again because they came back into view
+	int coldHits;
+
+	// Counted by the last draw
+	int drawnChunks;
+	int drawnTriangles;
+
+	// New chunks count as last visible at the previous draw, so the world can be used without a window
+	float drawTime;
+
 	Camera* camera;
 	Renderer* renderer;
 	GLuint shaderProgram;
 
-	int isNeighbourPresent(const std::vector<std::uint32_t>& blocks, int index, int dir);
+	std::string saveDirectory;
+	std::unordered_map<std::int64_t, std::unique_ptr<RegionFile>> regions;
+	// When each region was last used, the least recently used one is closed when too many are open
+	std::unordered_map<std::int64_t, std::uint64_t> regionUses;
+	std::uint64_t regionClock;
+
+	// Light is spread before the meshes are built
+	LightEngine lighting;
+
+	// With the octree backend the octree holds the blocks of every chunk that was loaded, and is the only copy of
+	// the ones that were unloaded since. Resident chunks are kept equal to it so they can be lit, meshed and drawn as usual.
+	std::unique_ptr<Octree> octree;
+	std::unordered_set<std::int64_t> octreeChunks;
+	size_t octreeCompactedNodes;
+	std::unordered_map<std::int64_t, glm::ivec3> unloadedEdits;
+
+	Chunk* addChunk(int pX, int pY, int pZ, bool pBounded);
+	Chunk* readChunk(int pX, int pY, int pZ);
+	Chunk* readOctreeChunk(int pX, int pY, int pZ);
+	bool setUnloadedBlock(glm::ivec3 pVoxel, std::uint8_t pId);
+	bool writeUnloadedEdits();
+	bool copyToOctree(Chunk& pChunk, Octree& pOctree);
+	void copyFromOctree(Chunk& pChunk, Octree& pOctree);
+	bool writeChunk(Chunk& pChunk);
+	RegionFile* getRegion(int pX, int pY, int pZ, bool pCreate);
+	RegionFile* findRegion(int pX, int pY, int pZ);
+	void closeLeastUsedRegion();
+	Chunk* getVoxelChunk(glm::ivec3 pVoxel, int& pIndex);
+	bool replaceBlock(Chunk& pChunk, int pIndex, std::uint8_t pId);
+	void cullFaces(Chunk& pChunk);
+	void updateFaces(Chunk& pChunk, int pIndex);
+	void updateFacesAround(glm::ivec3 pVoxel);
+	void updateNeighbours(glm::ivec3 pCoordinates);
+	void markBorderMeshesDirty(glm::ivec3 pCoordinates, glm::ivec3 pLocal);
+	void buildMesh(Chunk& pChunk);
+	int isNeighbourPresent(Chunk& pChunk, int index, int dir);
+	std::uint8_t getNeighbourLight(Chunk& pChunk, int pIndex, int pDir);
 };
\ No newline at end of file
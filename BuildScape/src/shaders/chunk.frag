@@ -0,0 +1,16 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 baseColor;
+in vec3 shade;
+in vec2 texCoord;
+flat in uint texLayer;
+
+uniform sampler2DArray blockTextures;
+uniform vec3 col;
+
+void main() {
+	// Faces without a texture keep the corner colours
+	vec3 color = texLayer == 0u ? baseColor : texture(blockTextures, vec3(texCoord, float(texLayer))).rgb;
+	FragColor = vec4(col + color * shade, 1.0);
+}
\ No newline at end of file
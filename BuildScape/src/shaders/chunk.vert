@@ -0,0 +1,40 @@
+#version 330 core
+layout(location = 0) in uvec2 aVertex;
+
+out vec3 baseColor;
+out vec3 shade;
+out vec2 texCoord;
+flat out uint texLayer;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 chunkOrigin;
+uniform float voxelSize;
+
+uniform usampler2D faceLayers;
+
+void main() {
+	// Unpack the block position, corner, occlusion and light
+	uint position = aVertex.x;
+	vec3 block = vec3(position & 63u, (position >> 6) & 63u, (position >> 12) & 63u);
+	uint cornerBits = (position >> 18) & 7u;
+	vec3 corner = vec3(cornerBits & 1u, (cornerBits >> 1) & 1u, (cornerBits >> 2) & 1u);
+	uint dir = (position >> 21) & 7u;
+	float occlusion = float((position >> 24) & 3u);
+	uint id = (aVertex.y >> 8) & 255u;
+	float level = float(max(aVertex.y & 15u, (aVertex.y >> 4) & 15u));
+
+	// Voxels are centred on their position
+	gl_Position = projection * view * vec4(chunkOrigin + (block + corner - 0.5) * voxelSize, 1.0);
+
+	// Every light level is a bit darker than the one above it, occluded corners are darker still
+	baseColor = corner;
+	shade = vec3(pow(0.8, 15.0 - level) * (0.4 + 0.2 * occlusion));
+
+	// Textures repeat every voxel along the face, so quads of any size tile them
+	vec3 voxel = block + corner;
+	if (dir < 2u) texCoord = vec2(voxel.z, -voxel.y);
+	else if (dir < 4u) texCoord = voxel.xz;
+	else texCoord = vec2(voxel.x, -voxel.y);
+	texLayer = texelFetch(faceLayers, ivec2(dir, id), 0).r;
+}
\ No newline at end of file
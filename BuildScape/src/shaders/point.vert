@@ -0,0 +1,14 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+
+out vec3 outColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform vec3 col;
+
+void main() {
+	gl_Position = projection * view * vec4(aPos, 1.0);
+	outColor = col;
+}
\ No newline at end of file